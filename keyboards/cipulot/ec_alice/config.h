@@ -37,24 +37,51 @@
 #define DISCHARGE_PIN A2
 #define ANALOG_PORT A3
 
+// Full 12 bit ADC resolution for the switch readings
+#ifdef EC_ADC_12BIT
+#    define ADC_RESOLUTION ADC_CR1_12B_RESOLUTION
+#endif
+
 #define DEFAULT_ACTUATION_MODE 0
-#define DEFAULT_APC_ACTUATION_LEVEL 550
-#define DEFAULT_APC_RELEASE_LEVEL 500
-#define DEFAULT_RT_INITIAL_DEADZONE_OFFSET DEFAULT_APC_ACTUATION_LEVEL
-#define DEFAULT_RT_ACTUATION_OFFSET 40
-#define DEFAULT_RT_RELEASE_OFFSET 40
+#ifdef EC_TRAVEL_THRESHOLDS_MM
+// Thresholds and offsets in 0.01 mm of travel
+#    define DEFAULT_APC_ACTUATION_LEVEL 200
+#    define DEFAULT_APC_RELEASE_LEVEL 180
+#    define DEFAULT_RT_INITIAL_DEADZONE_OFFSET DEFAULT_APC_ACTUATION_LEVEL
+#    define DEFAULT_RT_ACTUATION_OFFSET 30
+#    define DEFAULT_RT_RELEASE_OFFSET 30
+#else
+// Thresholds and offsets in 10 bit raw counts, scaled up to the ADC resolution
+#    define DEFAULT_APC_ACTUATION_LEVEL (550 << EC_ADC_EXTRA_BITS)
+#    define DEFAULT_APC_RELEASE_LEVEL (500 << EC_ADC_EXTRA_BITS)
+#    define DEFAULT_RT_INITIAL_DEADZONE_OFFSET DEFAULT_APC_ACTUATION_LEVEL
+#    define DEFAULT_RT_ACTUATION_OFFSET (40 << EC_ADC_EXTRA_BITS)
+#    define DEFAULT_RT_RELEASE_OFFSET (40 << EC_ADC_EXTRA_BITS)
+#endif
 #define DEFAULT_EXTREMUM 0
 #define EXPECTED_NOISE_FLOOR 0
-#define NOISE_FLOOR_THRESHOLD 25
-#define BOTTOMING_CALIBRATION_THRESHOLD 100
+#define NOISE_FLOOR_THRESHOLD (25 << EC_ADC_EXTRA_BITS)
+#define BOTTOMING_CALIBRATION_THRESHOLD (100 << EC_ADC_EXTRA_BITS)
 #define DEFAULT_NOISE_FLOOR_SAMPLING_COUNT 30
-#define DEFAULT_BOTTOMING_CALIBRATION_READING 1023
+#define DEFAULT_BOTTOMING_CALIBRATION_READING EC_ADC_MAX
 #define DEFAULT_CALIBRATION_STARTER true
 
 #define CHARGE_TIME 1
 #define DISCHARGE_TIME 10
 
-#define EECONFIG_KB_DATA_SIZE (38 + (11 * MATRIX_ROWS * MATRIX_COLS))
+// 12 bit RT offsets take two bytes each
+#ifdef EC_ADC_12BIT
+#    define EECONFIG_KB_DATA_SIZE (38 + (13 * MATRIX_ROWS * MATRIX_COLS))
+#else
+#    define EECONFIG_KB_DATA_SIZE (38 + (11 * MATRIX_ROWS * MATRIX_COLS))
+#endif
+
+// Split transaction used to sync the EC config
+#ifdef SPLIT_KEYBOARD
+#    ifndef SPLIT_TRANSACTION_IDS_KB
+#        define SPLIT_TRANSACTION_IDS_KB RPC_ID_EC_CONFIG_SYNC
+#    endif
+#endif
 
 // RGB & Indicators
 // PWM driver with direct memory access (DMA) support
@@ -15,10 +15,19 @@
  */
 
 #include "ec_switch_matrix.h"
+#include "ec_log.h"
 #include "keyboard.h"
 
 #ifdef SPLIT_KEYBOARD
-#    include "transactions.h"
+#    include "ec_split.h"
+#endif
+
+#ifdef EC_ANALOG_STREAM_ENABLE
+#    include "ec_analog_stream.h"
+#endif
+
+#ifdef EC_MIDI_ENABLE
+#    include "ec_midi.h"
 #endif
 
 // EEPROM default initialization
@@ -115,9 +124,14 @@ void keyboard_post_init_kb(void) {
             bulk_rescale_key_thresholds(key_runtime, key_eeprom, RESCALE_MODE_ALL);
         }
     }
-    // Register RPC handler for VIA commands if split keyboard
+    // Register the EC config and analog sync handlers if split keyboard
 #ifdef SPLIT_KEYBOARD
-    transaction_register_rpc(RPC_ID_VIA_CMD, via_cmd_slave_handler);
+    ec_split_init();
+#endif
+
+#ifdef EC_MIDI_ENABLE
+    // Build the MIDI key lookup
+    ec_midi_init();
 #endif
 
     // Copy SOCD cleaner pairs to runtime instance
@@ -126,88 +140,199 @@ void keyboard_post_init_kb(void) {
     // Set the RGB LEDs range that will be used for the effects
     rgblight_set_effect_range(3, 36);
 
-    // Call the indicator callback to set the indicator color
+    // Cache the indicator colors and set the indicators
+    indicators_refresh_colors();
     indicators_callback();
 
     // Call user post-initialization
     keyboard_post_init_user();
 }
 
+// Housekeeping task, runs once per main loop iteration
+void housekeeping_task_kb(void) {
+    // Drain the deferred console log
+    ec_log_task();
+
+#ifdef EC_ANALOG_STREAM_ENABLE
+    // Transmit the pending analog stream packets
+    ec_analog_stream_task();
+#endif
+
+#ifdef EC_MIDI_ENABLE
+    // Send the MIDI messages generated by the matrix scan
+    ec_midi_task();
+#endif
+
+#ifdef EC_ONLINE_CALIBRATION_ENABLE
+    // Save the bottom-out readings tracked in the background
+    ec_online_calibration_task();
+#endif
+
+#ifdef SPLIT_KEYBOARD
+    // Sync the EC config with the slave half
+    ec_split_task();
+#endif
+
+#ifdef CAPS_WORD_ENABLE
+    // Refresh the indicators when caps word toggles, caps_word_set_user() stays free for the keymaps
+    static bool caps_word_active = false;
+    if (is_caps_word_on() != caps_word_active) {
+        caps_word_active = !caps_word_active;
+        indicators_callback();
+    }
+#endif
+
+    // Call user housekeeping
+    housekeeping_task_user();
+}
+
+// Cached RGB value of each indicator, refreshed only when the VIA config changes
+static RGB     indicator_colors[EC_INDICATOR_COUNT];
+static uint8_t indicator_mask  = 0;    // Lit indicators as of the last flush
+static bool    indicator_dirty = true; // Colors changed since the last flush
+
+#ifdef EC_IDLE_SCAN_ENABLE
+// Scan at the reduced rate while the host is suspended
+void suspend_power_down_kb(void) {
+    ec_idle_scan_enter();
+    suspend_power_down_user();
+}
+#endif
+
 // This function gets called when caps, num, scroll change
 bool led_update_kb(led_t led_state) {
     indicators_callback();
     return true;
 }
 
-// This function is called when layers change
-__attribute__((weak)) layer_state_t layer_state_set_user(layer_state_t state) {
-    indicators_callback();
+// This function is called when layers change, before layer_state is updated
+layer_state_t layer_state_set_kb(layer_state_t state) {
+    state = layer_state_set_user(state);
+    indicators_update(state);
     return state;
 }
 
-bool func_switch(uint8_t func) {
-    switch (func) {
-        case 0x00: {
-            return false;
-            break;
-        }
-        case 0x01: // If indicator is set as caps lock
-        {
-            if (host_keyboard_led_state().caps_lock) return true;
-            break;
-        }
-        case 0x02: // If indicator is set as num lock
-        {
-            if (host_keyboard_led_state().num_lock) return true;
-            break;
-        }
-        case 0x03: // If indicator is set as scroll lock
-        {
-            if (host_keyboard_led_state().scroll_lock) return true;
-            break;
-        }
-        case 0x04: // If indicator is set as layer 0
-        case 0x05: // layer 1
-        case 0x06: // layer 2
-        case 0x07: // layer 3
-        case 0x08: // layer 4
-        case 0x09: // layer 5
-        case 0x0A: // layer 6
-        case 0x0B: // layer 7
-        {
-            if (IS_LAYER_ON((int)(func)-4)) return true;
-            break;
-        }
-        default: {
-            return false;
+// Indicator function predicates, indexed by the func code
+typedef bool (*indicator_func_t)(uint8_t func, layer_state_t state);
+
+static bool indicator_func_caps_lock(uint8_t func, layer_state_t state) {
+    return host_keyboard_led_state().caps_lock;
+}
+
+static bool indicator_func_num_lock(uint8_t func, layer_state_t state) {
+    return host_keyboard_led_state().num_lock;
+}
+
+static bool indicator_func_scroll_lock(uint8_t func, layer_state_t state) {
+    return host_keyboard_led_state().scroll_lock;
+}
+
+static bool indicator_func_layer(uint8_t func, layer_state_t state) {
+    return layer_state_cmp(state, func - 0x04);
+}
+
+static bool indicator_func_any_layer(uint8_t func, layer_state_t state) {
+    return get_highest_layer(state) > 0;
+}
+
+static bool indicator_func_caps(uint8_t func, layer_state_t state) {
+#ifdef CAPS_WORD_ENABLE
+    if (is_caps_word_on()) return true;
+#endif
+    return host_keyboard_led_state().caps_lock;
+}
+
+static bool indicator_func_bottoming_calibration(uint8_t func, layer_state_t state) {
+    return runtime_ec_config.bottoming_calibration;
+}
+
+static bool indicator_func_rapid_trigger(uint8_t func, layer_state_t state) {
+    // Lit as soon as any key uses one of the Rapid Trigger modes
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            if (runtime_ec_config.runtime_key_state[row][col].actuation_mode >= 1) {
+                return true;
+            }
         }
     }
     return false;
 }
 
-bool set_indicator(indicator_config indicator) {
-    if (!indicator.enabled) return false;
-    return func_switch(indicator.func & 0x0F);
+static const indicator_func_t indicator_funcs[16] = {
+    // clang-format off
+    [0x00] = NULL,                                 // Disabled
+    [0x01] = indicator_func_caps_lock,             // Caps lock
+    [0x02] = indicator_func_num_lock,              // Num lock
+    [0x03] = indicator_func_scroll_lock,           // Scroll lock
+    [0x04] = indicator_func_layer,                 // Layer 0
+    [0x05] = indicator_func_layer,                 // Layer 1
+    [0x06] = indicator_func_layer,                 // Layer 2
+    [0x07] = indicator_func_layer,                 // Layer 3
+    [0x08] = indicator_func_layer,                 // Layer 4
+    [0x09] = indicator_func_layer,                 // Layer 5
+    [0x0A] = indicator_func_layer,                 // Layer 6
+    [0x0B] = indicator_func_layer,                 // Layer 7
+    [0x0C] = indicator_func_any_layer,             // Any layer above the base layer
+    [0x0D] = indicator_func_caps,                  // Caps lock or caps word
+    [0x0E] = indicator_func_bottoming_calibration, // Bottoming calibration in progress
+    [0x0F] = indicator_func_rapid_trigger,         // Rapid Trigger or Velocity Rapid Trigger actuation mode
+    // clang-format on
+};
+
+// Refresh the cached indicator colors, call when the indicator config changes
+void indicators_refresh_colors(void) {
+    for (uint8_t index = 0; index < EC_INDICATOR_COUNT; index++) {
+        indicator_config *current_indicator_p = get_indicator_p(index);
+        /*
+           Issue: while the VIA custom GUI returns HSV values, the QMK direct operation funcs are RGB.
+           The conversion is done once here rather than on every indicator update. It is not done at the
+           get value VIA callback because the RGB to HSV conversion required there throttles the keyboard
+           when the user is adjusting the color on the GUI.
+        */
+        indicator_colors[index] = hsv_to_rgb((HSV){current_indicator_p->h, current_indicator_p->s, current_indicator_p->v});
+    }
+    indicator_dirty = true;
 }
 
-bool indicators_callback(void) {
-    // Basic functioning: for each indicator, set_indicator is used to decide if the current indicator should be lit or off.
-    indicator_config *current_indicator_p;
-    int               index;
-    RGB               color;
-    for (index = 0; index < 3; index++) {
-        current_indicator_p = get_indicator_p(index);
-        if (set_indicator(*(current_indicator_p))) {
-            /*
-               Issue: while the VIA custom GUI returns HSV values, the QMK direct operation funcs are RGB.
-               So this line converts the current indicator to RGB. This was not done at the indicator_config_set_value VIA callback function
-               because at the indicator_config_get_value the RGB to HSV would be required and this throttles the keyboard
-               when the user is adjusting the color on the GUI.
-            */
-            color = hsv_to_rgb((HSV){current_indicator_p->h, current_indicator_p->s, current_indicator_p->v});
-            rgblight_setrgb_at(color.r, color.g, color.b, current_indicator_p->index);
-        } else
-            rgblight_setrgb_at(RGB_OFF, current_indicator_p->index);
+// Compute the lit indicators for the given layer state and flush the strip if they changed
+bool indicators_update(layer_state_t state) {
+    uint8_t mask = 0;
+
+    for (uint8_t index = 0; index < EC_INDICATOR_COUNT; index++) {
+        indicator_config *current_indicator_p = get_indicator_p(index);
+        indicator_func_t  func                = indicator_funcs[current_indicator_p->func & 0x0F];
+        if (current_indicator_p->enabled && func && func(current_indicator_p->func & 0x0F, state)) {
+            mask |= 1 << index;
+        }
+    }
+
+    if (mask == indicator_mask && !indicator_dirty) {
+        return false;
     }
+    // Nothing to write while the strip is off, flush once it comes back
+    if (!rgblight_is_enabled()) {
+        indicator_dirty = true;
+        return false;
+    }
+
+    // Update the LED buffer, then refresh the strip once
+    for (uint8_t index = 0; index < EC_INDICATOR_COUNT; index++) {
+        indicator_config *current_indicator_p = get_indicator_p(index);
+        if (current_indicator_p->index >= RGBLIGHT_LED_COUNT) continue;
+        if (mask & (1 << index)) {
+            setrgb(indicator_colors[index].r, indicator_colors[index].g, indicator_colors[index].b, &led[current_indicator_p->index]);
+        } else {
+            setrgb(RGB_OFF, &led[current_indicator_p->index]);
+        }
+    }
+    rgblight_set();
+
+    indicator_mask  = mask;
+    indicator_dirty = false;
     return true;
 }
+
+// Update the indicators for the current layer state
+bool indicators_callback(void) {
+    return indicators_update(layer_state);
+}
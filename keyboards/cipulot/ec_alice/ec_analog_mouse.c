@@ -0,0 +1,151 @@
+/* Copyright 2026 Cipulot
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ec_analog_mouse.h"
+#include "ec_switch_matrix.h"
+#include "host.h"
+#include "timer.h"
+#include "util.h"
+#include <string.h>
+
+#ifdef MOUSEKEY_ENABLE
+#    include "mousekey.h"
+#endif
+
+#ifdef EC_ANALOG_MOUSE_LAYER
+#    include "action_layer.h"
+#endif
+
+// Analog mouse key definition
+typedef struct {
+    uint8_t row;
+    uint8_t col;
+    uint8_t direction; // ec_analog_mouse_direction_t
+} ec_analog_mouse_key_t;
+
+static const ec_analog_mouse_key_t mouse_keys[] = EC_ANALOG_MOUSE_KEYS;
+#define EC_ANALOG_MOUSE_KEY_COUNT ARRAY_SIZE(mouse_keys)
+
+// Speed at bottom-out in 1/256 units per tick
+#define EC_ANALOG_MOUSE_MAX_STEP ((int32_t)EC_ANALOG_MOUSE_MAX_SPEED * 256 * EC_ANALOG_MOUSE_INTERVAL / 1000)
+#define EC_ANALOG_MOUSE_WHEEL_MAX_STEP ((int32_t)EC_ANALOG_MOUSE_WHEEL_MAX_SPEED * 256 * EC_ANALOG_MOUSE_INTERVAL / 1000)
+
+// Pointer axes
+enum { AXIS_X, AXIS_Y, AXIS_V, AXIS_H, AXIS_COUNT };
+
+// Axis and sign of each direction
+static const struct {
+    uint8_t axis;
+    int8_t  sign;
+} direction_axis[] = {
+    // clang-format off
+    [EC_MOUSE_UP]          = {AXIS_Y, -1},
+    [EC_MOUSE_DOWN]        = {AXIS_Y,  1},
+    [EC_MOUSE_LEFT]        = {AXIS_X, -1},
+    [EC_MOUSE_RIGHT]       = {AXIS_X,  1},
+    [EC_MOUSE_WHEEL_UP]    = {AXIS_V,  1},
+    [EC_MOUSE_WHEEL_DOWN]  = {AXIS_V, -1},
+    [EC_MOUSE_WHEEL_LEFT]  = {AXIS_H, -1},
+    [EC_MOUSE_WHEEL_RIGHT] = {AXIS_H,  1},
+    // clang-format on
+};
+
+static int32_t  accumulator[AXIS_COUNT]; // Movement not reported yet, in 1/256 units
+static uint32_t next_tick = 0;           // Time of the next report
+
+// Check if the analog mouse keys are active
+static inline bool ec_analog_mouse_active(void) {
+#ifdef EC_ANALOG_MOUSE_LAYER
+    return layer_state_is(EC_ANALOG_MOUSE_LAYER);
+#else
+    return true;
+#endif
+}
+
+// Check if a key moves the pointer instead of going to the keyboard matrix
+bool ec_analog_mouse_claimed(uint8_t row, uint8_t col) {
+    if (!ec_analog_mouse_active()) {
+        return false;
+    }
+    for (uint8_t i = 0; i < EC_ANALOG_MOUSE_KEY_COUNT; i++) {
+        if (mouse_keys[i].row == row && mouse_keys[i].col == col) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Take the whole units out of an accumulator, keeping the sub-unit remainder
+static int8_t ec_analog_mouse_take(int32_t *acc) {
+    int32_t units = *acc / 256;
+    *acc -= units * 256;
+    return MAX(MIN(units, 127), -127);
+}
+
+// Report the pointer movement at a fixed rate, called after each matrix scan
+void ec_analog_mouse_task(void) {
+    uint32_t now = timer_read32();
+    if ((int32_t)(now - next_tick) < 0) {
+        return;
+    }
+    // Keep a fixed cadence, resync after a stall instead of catching up
+    next_tick += EC_ANALOG_MOUSE_INTERVAL;
+    if ((int32_t)(now - next_tick) >= 0) {
+        next_tick = now + EC_ANALOG_MOUSE_INTERVAL;
+    }
+
+    if (!ec_analog_mouse_active()) {
+        memset(accumulator, 0, sizeof(accumulator));
+        return;
+    }
+
+    // Step of each axis this tick, proportional to the depth past the deadzone
+    int32_t step[AXIS_COUNT] = {0};
+    for (uint8_t i = 0; i < EC_ANALOG_MOUSE_KEY_COUNT; i++) {
+        uint8_t depth = ec_get_key_depth(mouse_keys[i].row, mouse_keys[i].col);
+        if (depth <= EC_ANALOG_MOUSE_DEADZONE) {
+            continue;
+        }
+        uint8_t axis     = direction_axis[mouse_keys[i].direction].axis;
+        int32_t max_step = axis <= AXIS_Y ? EC_ANALOG_MOUSE_MAX_STEP : EC_ANALOG_MOUSE_WHEEL_MAX_STEP;
+        step[axis] += direction_axis[mouse_keys[i].direction].sign * (depth - EC_ANALOG_MOUSE_DEADZONE) * max_step / (255 - EC_ANALOG_MOUSE_DEADZONE);
+    }
+
+    bool moved = false;
+    for (uint8_t axis = 0; axis < AXIS_COUNT; axis++) {
+        if (step[axis] == 0) {
+            // Drop the remainder so the next press starts from a clean state
+            accumulator[axis] = 0;
+        } else {
+            accumulator[axis] += step[axis];
+            moved |= accumulator[axis] >= 256 || accumulator[axis] <= -256;
+        }
+    }
+    if (!moved) {
+        return;
+    }
+
+    report_mouse_t report = {0};
+#ifdef MOUSEKEY_ENABLE
+    // Keep the buttons held through mousekeys
+    report.buttons = mousekey_get_report().buttons;
+#endif
+    report.x = ec_analog_mouse_take(&accumulator[AXIS_X]);
+    report.y = ec_analog_mouse_take(&accumulator[AXIS_Y]);
+    report.v = ec_analog_mouse_take(&accumulator[AXIS_V]);
+    report.h = ec_analog_mouse_take(&accumulator[AXIS_H]);
+    host_mouse_send(&report);
+}
@@ -0,0 +1,66 @@
+/* Copyright 2026 Cipulot
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Pointer action of an analog mouse key
+typedef enum {
+    // clang-format off
+    EC_MOUSE_UP,
+    EC_MOUSE_DOWN,
+    EC_MOUSE_LEFT,
+    EC_MOUSE_RIGHT,
+    EC_MOUSE_WHEEL_UP,
+    EC_MOUSE_WHEEL_DOWN,
+    EC_MOUSE_WHEEL_LEFT,
+    EC_MOUSE_WHEEL_RIGHT
+    // clang-format on
+} ec_analog_mouse_direction_t;
+
+// Keys moving the pointer: { row, col, direction } entries, defined by the keymap
+#ifndef EC_ANALOG_MOUSE_KEYS
+#    error "EC_ANALOG_MOUSE_KEYS must list the analog mouse keys as { row, col, direction } entries"
+#endif
+
+// Time between two pointer reports in ms
+#ifndef EC_ANALOG_MOUSE_INTERVAL
+#    define EC_ANALOG_MOUSE_INTERVAL 5
+#endif
+
+// Depth ignored at the top of the travel, 0 at rest to 255 at bottom-out
+#ifndef EC_ANALOG_MOUSE_DEADZONE
+#    define EC_ANALOG_MOUSE_DEADZONE 24
+#endif
+
+// Cursor speed at bottom-out in pixels per second
+#ifndef EC_ANALOG_MOUSE_MAX_SPEED
+#    define EC_ANALOG_MOUSE_MAX_SPEED 1600
+#endif
+
+// Scroll speed at bottom-out in wheel steps per second
+#ifndef EC_ANALOG_MOUSE_WHEEL_MAX_SPEED
+#    define EC_ANALOG_MOUSE_WHEEL_MAX_SPEED 40
+#endif
+
+// EC_ANALOG_MOUSE_LAYER: if defined, the keys only move the pointer while this layer is on
+
+_Static_assert(EC_ANALOG_MOUSE_DEADZONE < 255, "EC_ANALOG_MOUSE_DEADZONE must be below 255");
+
+bool ec_analog_mouse_claimed(uint8_t row, uint8_t col);
+void ec_analog_mouse_task(void);
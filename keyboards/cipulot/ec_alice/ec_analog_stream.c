@@ -0,0 +1,239 @@
+/* Copyright 2026 Cipulot
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ec_analog_stream.h"
+#include "raw_hid.h"
+#include "timer.h"
+#include "usb_descriptor.h"
+#include <string.h>
+
+// Total number of matrix positions streamed per frame
+#define STREAM_KEY_COUNT (MATRIX_ROWS * MATRIX_COLS)
+// Packet header size: [ command_id, type, sequence, count ]
+#define STREAM_HEADER_SIZE 4
+// Payload bytes available in a single raw HID packet
+#define STREAM_PAYLOAD_SIZE (RAW_EPSIZE - STREAM_HEADER_SIZE)
+// Number of 12-bit values in a full packet (two values every three bytes)
+#define STREAM_FULL_VALUES_PER_PACKET ((STREAM_PAYLOAD_SIZE / 3) * 2)
+// Number of [ key index, value low, value high ] triplets in a delta packet
+#define STREAM_DELTA_ENTRIES_PER_PACKET (STREAM_PAYLOAD_SIZE / 3)
+
+_Static_assert(STREAM_KEY_COUNT <= 0xFF, "Analog stream key index doesn't fit in a single byte");
+
+// Stream configuration
+static struct {
+    bool     enabled;           // Streaming active
+    uint8_t  interval;          // Interval between frames in ms
+    uint8_t  flags;             // EC_STREAM_FLAG_* bits
+    uint8_t  keyframe_interval; // Delta frames between two full frames
+    uint8_t  delta_threshold;   // Minimum change to send a key in a delta frame
+} stream_config = {
+    .enabled           = false,
+    .interval          = EC_ANALOG_STREAM_DEFAULT_INTERVAL,
+    .flags             = EC_STREAM_FLAG_DELTA,
+    .keyframe_interval = EC_ANALOG_STREAM_DEFAULT_KEYFRAME_INTERVAL,
+    .delta_threshold   = EC_ANALOG_STREAM_DEFAULT_DELTA_THRESHOLD,
+};
+
+// Double buffer: the scanner writes the back buffer while housekeeping transmits the other one
+static uint16_t stream_buffer[2][MATRIX_ROWS][MATRIX_COLS];
+static uint8_t  back_index  = 0;     // Buffer the next snapshot goes to
+static bool     frame_ready = false; // Back buffer holds a snapshot not yet transmitted
+
+// Transmission state
+static bool     sending               = false; // A frame is being transmitted
+static bool     sending_full          = false; // Current frame is a full frame
+static bool     frame_packet_sent     = false; // At least one packet of the current frame was sent
+static uint8_t  tx_index              = 0;     // Buffer being transmitted
+static uint8_t  tx_key                = 0;     // Next key index to transmit
+static uint8_t  sequence              = 0;     // Frame sequence number
+static uint8_t  frames_since_keyframe = 0;     // Delta frames sent since the last full frame
+static uint32_t snapshot_timer        = 0;     // Time of the last snapshot
+static uint32_t dropped_frames        = 0;     // Snapshots overwritten before being transmitted
+
+// Last transmitted value of every key, reference for the delta frames
+static uint16_t last_sent[STREAM_KEY_COUNT];
+
+// Take a snapshot of the switch values, called at the end of every matrix scan
+void ec_analog_stream_snapshot(const uint16_t values[MATRIX_ROWS][MATRIX_COLS]) {
+    if (!stream_config.enabled || timer_elapsed32(snapshot_timer) < stream_config.interval) {
+        return;
+    }
+    snapshot_timer = timer_read32();
+
+    // Never touch the buffer under transmission
+    uint8_t target = sending ? (tx_index ^ 1) : back_index;
+    // Previous snapshot was not picked up yet, it gets replaced by the fresher one
+    if (frame_ready) {
+        dropped_frames++;
+    }
+    memcpy(stream_buffer[target], values, sizeof(stream_buffer[target]));
+    back_index  = target;
+    frame_ready = true;
+}
+
+// Fill the payload of a full packet, returns the number of keys packed
+static uint8_t stream_fill_full(const uint16_t *values, uint8_t *payload) {
+    uint8_t count = 0;
+    while (count < STREAM_FULL_VALUES_PER_PACKET && tx_key < STREAM_KEY_COUNT) {
+        uint16_t value = values[tx_key] & 0x0FFF;
+        // Two 12-bit values share three bytes
+        if ((count & 1) == 0) {
+            payload[0] = value & 0xFF;
+            payload[1] = value >> 8;
+        } else {
+            payload[1] |= (value & 0x0F) << 4;
+            payload[2] = value >> 4;
+            payload += 3;
+        }
+        last_sent[tx_key] = value;
+        tx_key++;
+        count++;
+    }
+    return count;
+}
+
+// Fill the payload of a delta packet, returns the number of triplets
+static uint8_t stream_fill_delta(const uint16_t *values, uint8_t *payload) {
+    uint8_t count = 0;
+    while (count < STREAM_DELTA_ENTRIES_PER_PACKET && tx_key < STREAM_KEY_COUNT) {
+        uint16_t value = values[tx_key];
+        uint16_t delta = value > last_sent[tx_key] ? value - last_sent[tx_key] : last_sent[tx_key] - value;
+        if (delta >= stream_config.delta_threshold) {
+            payload[0]        = tx_key;
+            payload[1]        = value & 0xFF;
+            payload[2]        = value >> 8;
+            payload          += 3;
+            last_sent[tx_key] = value;
+            count++;
+        }
+        tx_key++;
+    }
+    return count;
+}
+
+// Transmit pending frames, one raw HID packet per call to keep housekeeping short
+void ec_analog_stream_task(void) {
+    if (!stream_config.enabled) {
+        return;
+    }
+
+    // Pick up the latest snapshot
+    if (!sending) {
+        if (!frame_ready) {
+            return;
+        }
+        tx_index          = back_index;
+        back_index       ^= 1;
+        frame_ready       = false;
+        sending           = true;
+        frame_packet_sent = false;
+        tx_key            = 0;
+        sequence++;
+        // Full frame when delta compression is off or a key frame is due
+        sending_full = !(stream_config.flags & EC_STREAM_FLAG_DELTA) || frames_since_keyframe >= stream_config.keyframe_interval;
+        frames_since_keyframe = sending_full ? 0 : frames_since_keyframe + 1;
+    }
+
+    const uint16_t *values = &stream_buffer[tx_index][0][0];
+    uint8_t         packet[RAW_EPSIZE];
+    uint8_t         first_key = tx_key;
+    uint8_t         count;
+
+    memset(packet, 0, sizeof(packet));
+    if (sending_full) {
+        count     = stream_fill_full(values, &packet[STREAM_HEADER_SIZE]);
+        packet[1] = EC_STREAM_PACKET_FULL;
+        packet[3] = first_key;
+    } else {
+        count     = stream_fill_delta(values, &packet[STREAM_HEADER_SIZE]);
+        packet[1] = EC_STREAM_PACKET_DELTA;
+        packet[3] = count;
+    }
+
+    bool last = tx_key >= STREAM_KEY_COUNT;
+    if (last) {
+        sending = false;
+        // Nothing changed in this delta frame, skip it entirely
+        if (!sending_full && count == 0 && !frame_packet_sent) {
+            return;
+        }
+        packet[1] |= EC_STREAM_PACKET_LAST;
+    }
+
+    packet[0] = EC_ANALOG_STREAM_COMMAND_ID;
+    packet[2] = sequence;
+    raw_hid_send(packet, RAW_EPSIZE);
+    frame_packet_sent = true;
+}
+
+// Handle the stream commands received over raw HID, returns true if the command was handled
+bool ec_analog_stream_command(uint8_t *data, uint8_t length) {
+    // data = [ command_id, sub_command, args... ]
+    if (data[0] != EC_ANALOG_STREAM_COMMAND_ID) {
+        return false;
+    }
+
+    switch (data[1]) {
+        case EC_STREAM_CMD_START: {
+            stream_config.interval          = data[2] ? data[2] : EC_ANALOG_STREAM_DEFAULT_INTERVAL;
+            stream_config.flags             = data[3];
+            stream_config.keyframe_interval = data[4] ? data[4] : EC_ANALOG_STREAM_DEFAULT_KEYFRAME_INTERVAL;
+            stream_config.delta_threshold   = data[5] ? data[5] : EC_ANALOG_STREAM_DEFAULT_DELTA_THRESHOLD;
+            // Restart from a full frame
+            frame_ready           = false;
+            sending               = false;
+            frames_since_keyframe = stream_config.keyframe_interval;
+            dropped_frames        = 0;
+            stream_config.enabled = true;
+            break;
+        }
+        case EC_STREAM_CMD_STOP: {
+            stream_config.enabled = false;
+            frame_ready           = false;
+            sending               = false;
+            break;
+        }
+        case EC_STREAM_CMD_STATUS: {
+            break;
+        }
+        default: {
+            data[0] = 0xFF; // id_unhandled
+            raw_hid_send(data, length);
+            return true;
+        }
+    }
+
+    // Reply with the current status: [ command_id, sub_command, enabled, interval, flags, keyframe_interval, delta_threshold, dropped (4 bytes LE), sequence ]
+    data[2]  = stream_config.enabled;
+    data[3]  = stream_config.interval;
+    data[4]  = stream_config.flags;
+    data[5]  = stream_config.keyframe_interval;
+    data[6]  = stream_config.delta_threshold;
+    data[7]  = dropped_frames & 0xFF;
+    data[8]  = (dropped_frames >> 8) & 0xFF;
+    data[9]  = (dropped_frames >> 16) & 0xFF;
+    data[10] = (dropped_frames >> 24) & 0xFF;
+    data[11] = sequence;
+    raw_hid_send(data, length);
+
+    return true;
+}
+
+// Check if the stream is currently active
+bool ec_analog_stream_active(void) {
+    return stream_config.enabled;
+}
@@ -0,0 +1,67 @@
+/* Copyright 2026 Cipulot
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "matrix.h"
+
+// Raw HID command id used for the analog stream (outside the range used by VIA)
+#ifndef EC_ANALOG_STREAM_COMMAND_ID
+#    define EC_ANALOG_STREAM_COMMAND_ID 0xE0
+#endif
+
+// Default interval between two streamed frames in ms
+#ifndef EC_ANALOG_STREAM_DEFAULT_INTERVAL
+#    define EC_ANALOG_STREAM_DEFAULT_INTERVAL 10
+#endif
+
+// Number of delta frames sent between two full (key) frames
+#ifndef EC_ANALOG_STREAM_DEFAULT_KEYFRAME_INTERVAL
+#    define EC_ANALOG_STREAM_DEFAULT_KEYFRAME_INTERVAL 50
+#endif
+
+// Minimum change of a key reading for it to be included in a delta frame
+#ifndef EC_ANALOG_STREAM_DEFAULT_DELTA_THRESHOLD
+#    define EC_ANALOG_STREAM_DEFAULT_DELTA_THRESHOLD 2
+#endif
+
+// Stream sub-commands (host to keyboard), data = [ command_id, sub_command, args... ]
+typedef enum {
+    // clang-format off
+    EC_STREAM_CMD_STOP   = 0x00, // Stop streaming
+    EC_STREAM_CMD_START  = 0x01, // Start streaming: [ interval_ms, flags, keyframe_interval, delta_threshold ]
+    EC_STREAM_CMD_STATUS = 0x02  // Query the stream status
+    // clang-format on
+} ec_stream_command_t;
+
+// Stream start flags
+#define EC_STREAM_FLAG_DELTA 0x01 // Delta compress frames between key frames
+
+// Stream packet types (keyboard to host), packet = [ command_id, type, sequence, count, payload... ]
+typedef enum {
+    // clang-format off
+    EC_STREAM_PACKET_FULL  = 0x80, // Packed 12-bit values, count is the index of the first key
+    EC_STREAM_PACKET_DELTA = 0x81, // [ key index, value low, value high ] triplets, count is the number of triplets
+    EC_STREAM_PACKET_LAST  = 0x40  // Set on the last packet of a frame
+    // clang-format on
+} ec_stream_packet_t;
+
+void ec_analog_stream_snapshot(const uint16_t values[MATRIX_ROWS][MATRIX_COLS]);
+void ec_analog_stream_task(void);
+bool ec_analog_stream_command(uint8_t *data, uint8_t length);
+bool ec_analog_stream_active(void);
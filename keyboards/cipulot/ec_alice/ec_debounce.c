@@ -0,0 +1,90 @@
+/* Copyright 2026 Cipulot
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "debounce.h"
+#include "ec_switch_matrix.h"
+#include "timer.h"
+
+#ifndef DEBOUNCE
+#    define DEBOUNCE 5
+#endif
+
+_Static_assert(DEBOUNCE <= UINT8_MAX, "DEBOUNCE must fit in a byte");
+
+static uint8_t      countdowns[MATRIX_ROWS][MATRIX_COLS]; // Remaining defer time of each key in ms
+static matrix_row_t deferred[MATRIX_ROWS];                // Keys waiting for their defer time
+static bool         deferred_pending = false;             // Any key waiting
+static uint16_t     last_time        = 0;                 // Time of the previous call
+
+void debounce_init(uint8_t num_rows) {
+    last_time = timer_read();
+}
+
+void debounce_free(void) {}
+
+// APC and RT already apply an analog hysteresis, so transitions go through without delay.
+// Only keys whose noise at rest reaches their configured hysteresis get a per-key deferred debounce.
+bool debounce(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, bool changed) {
+    uint16_t now     = timer_read();
+    uint16_t elapsed = TIMER_DIFF_16(now, last_time);
+    last_time        = now;
+
+    if (!changed && !deferred_pending) {
+        return false;
+    }
+
+    bool cooked_changed = false;
+    deferred_pending    = false;
+
+    for (uint8_t row = 0; row < num_rows; row++) {
+        matrix_row_t delta = raw[row] ^ cooked[row];
+
+        // Transitions that reverted before the end of their defer time are dropped
+        deferred[row] &= delta;
+        if (!delta) {
+            continue;
+        }
+
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            matrix_row_t mask = (matrix_row_t)1 << col;
+            if (!(delta & mask)) {
+                continue;
+            }
+
+            if (DEBOUNCE > 0 && ec_key_is_noisy(row, col)) {
+                if (!(deferred[row] & mask)) {
+                    // Start the defer time
+                    deferred[row] |= mask;
+                    countdowns[row][col] = DEBOUNCE;
+                    deferred_pending     = true;
+                    continue;
+                }
+                if (countdowns[row][col] > elapsed) {
+                    countdowns[row][col] -= elapsed;
+                    deferred_pending = true;
+                    continue;
+                }
+                deferred[row] &= ~mask;
+            }
+
+            // Pass the transition through
+            cooked[row] ^= mask;
+            cooked_changed = true;
+        }
+    }
+
+    return cooked_changed;
+}
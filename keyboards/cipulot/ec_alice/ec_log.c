@@ -0,0 +1,319 @@
+/* Copyright 2026 Cipulot
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ec_log.h"
+#include "ec_switch_matrix.h"
+#include "print.h"
+
+#ifdef CONSOLE_ENABLE
+#    include "usb_endpoints.h"
+
+// Compact log record, formatted only when drained
+typedef struct {
+    uint8_t  id;      // ec_log_id_t
+    uint16_t args[2]; // Format arguments
+} ec_log_record_t;
+
+// Format strings, indexed by ec_log_id_t
+static const char *const log_formats[EC_LOG_ID_COUNT] = {
+    // clang-format off
+    [EC_LOG_ACTUATION_MODE_APC]            = "#########################\n#  Actuation Mode: APC  #\n#########################\n",
+    [EC_LOG_ACTUATION_MODE_RT]             = "#################################\n# Actuation Mode: Rapid Trigger #\n#################################\n",
+    [EC_LOG_ACTUATION_MODE_VRT]            = "##########################################\n# Actuation Mode: Velocity Rapid Trigger #\n##########################################\n",
+    [EC_LOG_APC_ACTUATION_THRESHOLD]       = "APC Mode Actuation Threshold: %d\n",
+    [EC_LOG_APC_RELEASE_THRESHOLD]         = "APC Mode Release Threshold: %d\n",
+    [EC_LOG_RT_INITIAL_DEADZONE_OFFSET]    = "Rapid Trigger Mode Initial Deadzone Offset: %d\n",
+    [EC_LOG_RT_ACTUATION_OFFSET]           = "Rapid Trigger Mode Actuation Offset: %d\n",
+    [EC_LOG_RT_RELEASE_OFFSET]             = "Rapid Trigger Mode Release Offset: %d\n",
+    [EC_LOG_BOTTOMING_CALIBRATION_START]   = "##############################\n# Bottoming calibration mode #\n##############################\n",
+    [EC_LOG_BOTTOMING_CALIBRATION_DONE]    = "## Bottoming calibration done ##\n",
+    [EC_LOG_BOTTOMING_CALIBRATION_CLEARED] = "######################################\n# Bottoming calibration data cleared #\n######################################\n",
+    [EC_LOG_NOISE_FLOOR_ACQUIRED]          = "#############################\n# Noise floor data acquired #\n#############################\n",
+    [EC_LOG_THRESHOLDS_SAVED]              = "####################################\n# New thresholds applied and saved #\n####################################\n",
+    [EC_LOG_IDLE_SCAN_WAKE]                = "Idle scan wake-up, latency: %u us (max %u us)\n",
+    [EC_LOG_SCAN_TIMING]                   = "Scan loop: %u cycles per key (max %u)\n",
+    // clang-format on
+};
+
+// Table titles, indexed by ec_log_table_t
+static const char *const table_titles[EC_LOG_TABLE_COUNT] = {
+    // clang-format off
+    [EC_LOG_TABLE_ACTUATION_MODE]      = "Actuation Mode",
+    [EC_LOG_TABLE_NOISE_FLOOR]         = "Noise Floor",
+    [EC_LOG_TABLE_EXTREMUM]            = "Extremum",
+    [EC_LOG_TABLE_BOTTOMING_READING]   = "Bottoming Readings",
+    [EC_LOG_TABLE_APC_ACTUATION]       = "APC Mode Actuation Threshold",
+    [EC_LOG_TABLE_APC_RELEASE]         = "APC Mode Release Threshold",
+    [EC_LOG_TABLE_RT_INITIAL_DEADZONE] = "Rapid Trigger Mode Initial Deadzone Offset",
+    [EC_LOG_TABLE_RT_ACTUATION]        = "Rapid Trigger Mode Actuation Offset",
+    [EC_LOG_TABLE_RT_RELEASE]          = "Rapid Trigger Mode Release Offset",
+    [EC_LOG_TABLE_SW_VALUE]            = "Switch Values",
+    [EC_LOG_TABLE_NOISE_AMPLITUDE]     = "Noise Amplitude",
+    [EC_LOG_TABLE_SNR]                 = "Signal to Noise Ratio",
+    [EC_LOG_TABLE_HYSTERESIS]          = "Effective Hysteresis",
+    [EC_LOG_TABLE_GUARDED]             = "Hysteresis Raised by the Noise Guard",
+    [EC_LOG_TABLE_STROKE_COUNT]        = "Stroke Count",
+    [EC_LOG_TABLE_BOTTOM_DRIFT]        = "Bottom-out Drift",
+    // clang-format on
+};
+
+// Ring buffer of pending records
+static ec_log_record_t log_buffer[EC_LOG_BUFFER_SIZE];
+static uint8_t         log_head    = 0; // Next slot to write
+static uint8_t         log_tail    = 0; // Next slot to drain
+static uint16_t        log_dropped = 0; // Records lost because the buffer was full
+
+// Table values taken when the table is logged, so a dump shows a single moment
+typedef struct {
+    uint8_t  table;                            // ec_log_table_t
+    uint16_t original;                         // Configured value of the rescaled tables
+    uint16_t values[MATRIX_ROWS][MATRIX_COLS]; // Cell values, signed tables stored as int16_t
+} ec_log_table_slot_t;
+
+// Slot index of a table record waiting for its snapshot
+#    define EC_LOG_TABLE_DEFERRED 0xFFFF
+
+static ec_log_table_slot_t table_slots[EC_LOG_TABLE_SLOTS];
+static uint8_t             table_slot_head  = 0; // Next slot to fill, the slots are used in record order
+static uint8_t             table_slot_count = 0; // Slots holding a table not fully printed yet
+static uint8_t             table_deferred   = 0; // Table records waiting for a free slot
+
+// Table currently being printed, one row per drain
+static struct {
+    bool    active;
+    uint8_t slot;
+    uint8_t row;
+} table_dump = {false, 0, 0};
+
+static void table_snapshot(ec_log_table_slot_t *slot, uint8_t table);
+
+// Snapshot a table into the next slot, returns the slot index
+static uint8_t table_slot_take(uint8_t table) {
+    uint8_t slot = table_slot_head;
+    table_snapshot(&table_slots[slot], table);
+    table_slot_head = (slot + 1) % EC_LOG_TABLE_SLOTS;
+    table_slot_count++;
+    return slot;
+}
+
+// Record a log message, never blocks: the record is dropped if the buffer is full
+void ec_log(ec_log_id_t id, uint16_t arg0, uint16_t arg1) {
+    uint8_t next = (log_head + 1) & (EC_LOG_BUFFER_SIZE - 1);
+    if (next == log_tail) {
+        if (log_dropped < UINT16_MAX) {
+            log_dropped++;
+        }
+        return;
+    }
+    if (id == EC_LOG_TABLE) {
+        if (arg0 >= EC_LOG_TABLE_COUNT) {
+            return;
+        }
+        if (!table_deferred && table_slot_count < EC_LOG_TABLE_SLOTS) {
+            // Take the values now, the record points at the snapshot
+            arg1 = table_slot_take(arg0);
+        } else {
+            // No free slot: the snapshot is taken when the table comes up, the later tables wait behind it
+            arg1 = EC_LOG_TABLE_DEFERRED;
+            table_deferred++;
+        }
+    }
+    log_buffer[log_head].id      = id;
+    log_buffer[log_head].args[0] = arg0;
+    log_buffer[log_head].args[1] = arg1;
+    log_head                     = next;
+}
+
+// Live value of a table cell
+static int32_t table_value(uint8_t table, uint8_t row, uint8_t col) {
+    runtime_key_state_t *key_runtime = &runtime_ec_config.runtime_key_state[row][col];
+    switch (table) {
+        case EC_LOG_TABLE_ACTUATION_MODE:
+            return eeprom_ec_config.eeprom_key_state[row][col].actuation_mode;
+        case EC_LOG_TABLE_NOISE_FLOOR:
+            return key_runtime->noise_floor;
+        case EC_LOG_TABLE_EXTREMUM:
+            return key_runtime->extremum;
+        case EC_LOG_TABLE_BOTTOMING_READING:
+            return key_runtime->bottoming_calibration_reading;
+        case EC_LOG_TABLE_APC_ACTUATION:
+            return key_runtime->rescaled_apc_actuation_threshold;
+        case EC_LOG_TABLE_APC_RELEASE:
+            return key_runtime->rescaled_apc_release_threshold;
+        case EC_LOG_TABLE_RT_INITIAL_DEADZONE:
+            return key_runtime->rescaled_rt_initial_deadzone_offset;
+        case EC_LOG_TABLE_RT_ACTUATION:
+            return key_runtime->rescaled_rt_actuation_offset;
+        case EC_LOG_TABLE_RT_RELEASE:
+            return key_runtime->rescaled_rt_release_offset;
+        case EC_LOG_TABLE_SW_VALUE:
+            return ec_get_sw_value(row, col);
+        case EC_LOG_TABLE_NOISE_AMPLITUDE:
+            return key_runtime->noise_amplitude;
+        case EC_LOG_TABLE_SNR:
+            return ec_get_key_snr(row, col);
+        case EC_LOG_TABLE_HYSTERESIS:
+            return ec_get_key_hysteresis(row, col);
+        case EC_LOG_TABLE_GUARDED:
+            return ec_key_is_guarded(row, col);
+#    ifdef EC_ONLINE_CALIBRATION_ENABLE
+        case EC_LOG_TABLE_STROKE_COUNT:
+            return MIN(key_runtime->stroke_count, UINT16_MAX);
+        case EC_LOG_TABLE_BOTTOM_DRIFT:
+            return ec_get_key_bottom_drift(row, col);
+#    endif
+        default:
+            return 0;
+    }
+}
+
+// Copy a table and the configured value of the rescaled tables into a slot
+static void table_snapshot(ec_log_table_slot_t *slot, uint8_t table) {
+    eeprom_key_state_t *key_eeprom = &eeprom_ec_config.eeprom_key_state[0][0];
+
+    slot->table = table;
+    switch (table) {
+        case EC_LOG_TABLE_APC_ACTUATION:
+            slot->original = key_eeprom->apc_actuation_threshold;
+            break;
+        case EC_LOG_TABLE_APC_RELEASE:
+            slot->original = key_eeprom->apc_release_threshold;
+            break;
+        case EC_LOG_TABLE_RT_INITIAL_DEADZONE:
+            slot->original = key_eeprom->rt_initial_deadzone_offset;
+            break;
+        case EC_LOG_TABLE_RT_ACTUATION:
+            slot->original = key_eeprom->rt_actuation_offset;
+            break;
+        case EC_LOG_TABLE_RT_RELEASE:
+            slot->original = key_eeprom->rt_release_offset;
+            break;
+        default:
+            slot->original = 0;
+            break;
+    }
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            slot->values[row][col] = table_value(table, row, col);
+        }
+    }
+}
+
+// Value of a snapshot cell
+static int32_t table_cell(ec_log_table_slot_t *slot, uint8_t row, uint8_t col) {
+    if (slot->table == EC_LOG_TABLE_BOTTOM_DRIFT) {
+        return (int16_t)slot->values[row][col];
+    }
+    return slot->values[row][col];
+}
+
+// Print the table header, including the configured value for the rescaled tables
+static void table_print_header(ec_log_table_slot_t *slot) {
+    uprintf("\n# %s #\n", table_titles[slot->table]);
+    switch (slot->table) {
+        case EC_LOG_TABLE_APC_ACTUATION:
+        case EC_LOG_TABLE_APC_RELEASE:
+        case EC_LOG_TABLE_RT_INITIAL_DEADZONE:
+        case EC_LOG_TABLE_RT_ACTUATION:
+        case EC_LOG_TABLE_RT_RELEASE:
+            uprintf("Original Value: %4d\nRescaled Values:\n", slot->original);
+            break;
+        default:
+            break;
+    }
+}
+
+// Print the next row of the active table, the slot is released after the last row
+static void table_print_row(void) {
+    ec_log_table_slot_t *slot = &table_slots[table_dump.slot];
+
+    for (uint8_t col = 0; col < MATRIX_COLS - 1; col++) {
+        uprintf("%4ld,", table_cell(slot, table_dump.row, col));
+    }
+    uprintf("%4ld\n", table_cell(slot, table_dump.row, MATRIX_COLS - 1));
+
+    if (++table_dump.row >= MATRIX_ROWS) {
+        table_dump.active = false;
+        table_slot_count--;
+    }
+}
+
+// Check if the console endpoint queue is empty, a write to a full one would wait for the host
+static bool console_ready(void) {
+    output_buffers_queue_t *queue = &usb_endpoints_in[USB_ENDPOINT_IN_CONSOLE].obqueue;
+
+    osalSysLock();
+    bool ready = bqSpaceI(queue) == bqSizeX(queue);
+    osalSysUnlock();
+
+    return ready;
+}
+
+// Print the next record or table row, returns false once there is nothing left
+static bool ec_log_drain(void) {
+    if (table_dump.active) {
+        table_print_row();
+    } else if (log_dropped) {
+        uprintf("[ec_log] %u messages dropped\n", log_dropped);
+        log_dropped = 0;
+    } else if (log_tail != log_head) {
+        ec_log_record_t *record = &log_buffer[log_tail];
+        log_tail                = (log_tail + 1) & (EC_LOG_BUFFER_SIZE - 1);
+
+        if (record->id == EC_LOG_TABLE) {
+            if (record->args[1] == EC_LOG_TABLE_DEFERRED) {
+                // Every earlier table is printed and every later one deferred, so the slots are free
+                table_deferred--;
+                record->args[1] = table_slot_take(record->args[0]);
+            }
+            table_dump.active = true;
+            table_dump.slot   = record->args[1];
+            table_dump.row    = 0;
+            table_print_header(&table_slots[table_dump.slot]);
+        } else if (record->id < EC_LOG_ID_COUNT && log_formats[record->id]) {
+            uprintf(log_formats[record->id], record->args[0], record->args[1]);
+        }
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Drain the log to the console while the console endpoint has room, the rest waits for the next call
+void ec_log_task(void) {
+    while (console_ready() && ec_log_drain()) {
+    }
+}
+
+#endif // CONSOLE_ENABLE
+
+// Queue the calibration tables for printing
+void ec_log_calibration_data(void) {
+    for (uint8_t table = EC_LOG_TABLE_ACTUATION_MODE; table <= EC_LOG_TABLE_RT_RELEASE; table++) {
+        ec_log(EC_LOG_TABLE, table, 0);
+    }
+    ec_log(EC_LOG_TABLE, EC_LOG_TABLE_NOISE_AMPLITUDE, 0);
+    ec_log(EC_LOG_TABLE, EC_LOG_TABLE_SNR, 0);
+    ec_log(EC_LOG_TABLE, EC_LOG_TABLE_HYSTERESIS, 0);
+    ec_log(EC_LOG_TABLE, EC_LOG_TABLE_GUARDED, 0);
+#ifdef EC_ONLINE_CALIBRATION_ENABLE
+    ec_log(EC_LOG_TABLE, EC_LOG_TABLE_STROKE_COUNT, 0);
+    ec_log(EC_LOG_TABLE, EC_LOG_TABLE_BOTTOM_DRIFT, 0);
+#endif
+#ifdef EC_SCAN_TIMING_ENABLE
+    ec_log(EC_LOG_SCAN_TIMING, ec_scan_timing_get_stats()->key_cycles_avg, ec_scan_timing_get_stats()->key_cycles_max);
+#endif
+}
@@ -0,0 +1,88 @@
+/* Copyright 2026 Cipulot
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+// Number of log records held in RAM, must be a power of two
+#ifndef EC_LOG_BUFFER_SIZE
+#    define EC_LOG_BUFFER_SIZE 32
+#endif
+
+// Number of table snapshots held in RAM until printed, further tables are snapshot when their turn comes
+#ifndef EC_LOG_TABLE_SLOTS
+#    define EC_LOG_TABLE_SLOTS 2
+#endif
+
+_Static_assert((EC_LOG_BUFFER_SIZE & (EC_LOG_BUFFER_SIZE - 1)) == 0, "EC_LOG_BUFFER_SIZE must be a power of two");
+_Static_assert(EC_LOG_TABLE_SLOTS >= 1, "EC_LOG_TABLE_SLOTS must be at least 1");
+
+// Log message identifiers, each one maps to a format string
+typedef enum {
+    // clang-format off
+    EC_LOG_ACTUATION_MODE_APC = 0,        // Actuation mode set to APC
+    EC_LOG_ACTUATION_MODE_RT,             // Actuation mode set to Rapid Trigger
+    EC_LOG_ACTUATION_MODE_VRT,            // Actuation mode set to Velocity Rapid Trigger
+    EC_LOG_APC_ACTUATION_THRESHOLD,       // arg0: threshold
+    EC_LOG_APC_RELEASE_THRESHOLD,         // arg0: threshold
+    EC_LOG_RT_INITIAL_DEADZONE_OFFSET,    // arg0: offset
+    EC_LOG_RT_ACTUATION_OFFSET,           // arg0: offset
+    EC_LOG_RT_RELEASE_OFFSET,             // arg0: offset
+    EC_LOG_BOTTOMING_CALIBRATION_START,   // Bottoming calibration mode entered
+    EC_LOG_BOTTOMING_CALIBRATION_DONE,    // Bottoming calibration mode left
+    EC_LOG_BOTTOMING_CALIBRATION_CLEARED, // Bottoming calibration data cleared
+    EC_LOG_NOISE_FLOOR_ACQUIRED,          // Noise floor calibration done
+    EC_LOG_THRESHOLDS_SAVED,              // Thresholds applied and saved
+    EC_LOG_IDLE_SCAN_WAKE,                // arg0: wake latency in us, arg1: max wake latency in us
+    EC_LOG_SCAN_TIMING,                   // arg0: filtered cycles per key, arg1: max cycles per key
+    EC_LOG_TABLE,                         // arg0: ec_log_table_t, snapshot when logged or when its turn comes, printed row by row
+    EC_LOG_ID_COUNT
+    // clang-format on
+} ec_log_id_t;
+
+// Per-key tables that can be dumped through the log
+typedef enum {
+    // clang-format off
+    EC_LOG_TABLE_ACTUATION_MODE = 0,
+    EC_LOG_TABLE_NOISE_FLOOR,
+    EC_LOG_TABLE_EXTREMUM,
+    EC_LOG_TABLE_BOTTOMING_READING,
+    EC_LOG_TABLE_APC_ACTUATION,
+    EC_LOG_TABLE_APC_RELEASE,
+    EC_LOG_TABLE_RT_INITIAL_DEADZONE,
+    EC_LOG_TABLE_RT_ACTUATION,
+    EC_LOG_TABLE_RT_RELEASE,
+    EC_LOG_TABLE_SW_VALUE,
+    EC_LOG_TABLE_NOISE_AMPLITUDE,
+    EC_LOG_TABLE_SNR,
+    EC_LOG_TABLE_HYSTERESIS,
+    EC_LOG_TABLE_GUARDED,
+    EC_LOG_TABLE_STROKE_COUNT,
+    EC_LOG_TABLE_BOTTOM_DRIFT,
+    EC_LOG_TABLE_COUNT
+    // clang-format on
+} ec_log_table_t;
+
+#ifdef CONSOLE_ENABLE
+void ec_log(ec_log_id_t id, uint16_t arg0, uint16_t arg1);
+void ec_log_task(void);
+#else
+#    define ec_log(id, arg0, arg1) ((void)0)
+#    define ec_log_task() ((void)0)
+#endif
+
+void ec_log_calibration_data(void);
@@ -0,0 +1,202 @@
+/* Copyright 2026 Cipulot
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ec_midi.h"
+#include "qmk_midi.h"
+#include "util.h"
+#include "raw_hid.h"
+#include <string.h>
+
+// MIDI key definition
+typedef struct {
+    uint8_t row;
+    uint8_t col;
+    uint8_t note;
+} ec_midi_key_t;
+
+static const ec_midi_key_t midi_keys[] = EC_MIDI_KEYS;
+#define EC_MIDI_KEY_COUNT ARRAY_SIZE(midi_keys)
+// Index meaning the key is not a MIDI key
+#define EC_MIDI_NO_KEY 0xFF
+
+_Static_assert(EC_MIDI_KEY_COUNT < EC_MIDI_NO_KEY, "Too many EC_MIDI_KEYS");
+
+// Per-note state
+typedef struct {
+    bool    on;         // Note playing
+    uint8_t aftertouch; // Last aftertouch pressure sent
+} ec_midi_note_t;
+
+// Queued MIDI message
+typedef struct {
+    uint8_t status; // MIDI status nibble
+    uint8_t note;   // Note number
+    uint8_t value;  // Velocity or pressure
+} ec_midi_message_t;
+
+// MIDI status nibbles
+#define MIDI_STATUS_NOTE_OFF 0x80
+#define MIDI_STATUS_NOTE_ON 0x90
+#define MIDI_STATUS_AFTERTOUCH 0xA0
+
+static bool              midi_enabled = false;
+static uint8_t           midi_index[MATRIX_ROWS][MATRIX_COLS]; // Index in midi_keys, EC_MIDI_NO_KEY otherwise
+static ec_midi_note_t    midi_notes[EC_MIDI_KEY_COUNT];
+static ec_midi_message_t midi_queue[EC_MIDI_QUEUE_SIZE];
+static uint8_t           queue_head    = 0; // Next slot to write
+static uint8_t           queue_tail    = 0; // Next slot to send
+static uint16_t          queue_dropped = 0; // Aftertouch messages dropped because the queue was full
+
+// Queue a message, returns false if the queue is full
+static bool ec_midi_queue(uint8_t status, uint8_t note, uint8_t value) {
+    uint8_t next = (queue_head + 1) & (EC_MIDI_QUEUE_SIZE - 1);
+    if (next == queue_tail) {
+        return false;
+    }
+    midi_queue[queue_head].status = status;
+    midi_queue[queue_head].note   = note;
+    midi_queue[queue_head].value  = value;
+    queue_head                    = next;
+    return true;
+}
+
+// Build the key lookup table
+void ec_midi_init(void) {
+    memset(midi_index, EC_MIDI_NO_KEY, sizeof(midi_index));
+    for (uint8_t i = 0; i < EC_MIDI_KEY_COUNT; i++) {
+        midi_index[midi_keys[i].row][midi_keys[i].col] = i;
+    }
+}
+
+// Enable or disable the MIDI mode, playing notes are ended when disabling
+void ec_midi_set_enabled(bool enabled) {
+    if (enabled == midi_enabled) {
+        return;
+    }
+    if (!enabled) {
+        // Send what is pending first so the note offs always find room in the queue
+        ec_midi_task();
+        for (uint8_t i = 0; i < EC_MIDI_KEY_COUNT; i++) {
+            if (midi_notes[i].on && !ec_midi_queue(MIDI_STATUS_NOTE_OFF, midi_keys[i].note, 0)) {
+                ec_midi_task();
+                ec_midi_queue(MIDI_STATUS_NOTE_OFF, midi_keys[i].note, 0);
+            }
+        }
+    }
+    memset(midi_notes, 0, sizeof(midi_notes));
+    midi_enabled = enabled;
+}
+
+// Check if the MIDI mode is enabled
+bool ec_midi_enabled(void) {
+    return midi_enabled;
+}
+
+// Check if a key is played as a MIDI note instead of going to the keyboard matrix
+bool ec_midi_claimed(uint8_t row, uint8_t col) {
+    return midi_enabled && midi_index[row][col] != EC_MIDI_NO_KEY;
+}
+
+// Generate the MIDI messages of a key from its new reading, called from the matrix scan
+void ec_midi_update_key(uint8_t row, uint8_t col, uint8_t depth, int16_t velocity) {
+    uint8_t         index = midi_index[row][col];
+    ec_midi_note_t *note  = &midi_notes[index];
+
+    if (!note->on) {
+        if (depth >= EC_MIDI_NOTE_ON_DEPTH) {
+            // Note velocity from the press speed, counts per ms
+            uint16_t speed         = velocity > 0 ? velocity >> 8 : 0;
+            uint8_t  note_velocity = MAX(MIN(speed * 127 / EC_MIDI_FULL_VELOCITY, 127), 1);
+            // Retried on the next scan if the queue is full
+            if (ec_midi_queue(MIDI_STATUS_NOTE_ON, midi_keys[index].note, note_velocity)) {
+                note->on         = true;
+                note->aftertouch = 0;
+            }
+        }
+    } else if (depth < EC_MIDI_NOTE_OFF_DEPTH) {
+        if (ec_midi_queue(MIDI_STATUS_NOTE_OFF, midi_keys[index].note, 0)) {
+            note->on = false;
+        }
+    } else {
+        // Aftertouch from the depth past the note on point
+        uint8_t pressure = depth > EC_MIDI_NOTE_ON_DEPTH ? (uint16_t)(depth - EC_MIDI_NOTE_ON_DEPTH) * 127 / (255 - EC_MIDI_NOTE_ON_DEPTH) : 0;
+        uint8_t change   = pressure > note->aftertouch ? pressure - note->aftertouch : note->aftertouch - pressure;
+        if (change >= EC_MIDI_AFTERTOUCH_STEP || (pressure == 0 && note->aftertouch != 0)) {
+            if (ec_midi_queue(MIDI_STATUS_AFTERTOUCH, midi_keys[index].note, pressure)) {
+                note->aftertouch = pressure;
+            } else if (queue_dropped < UINT16_MAX) {
+                queue_dropped++;
+            }
+        }
+    }
+}
+
+// Send the queued MIDI messages
+void ec_midi_task(void) {
+    while (queue_tail != queue_head) {
+        ec_midi_message_t *message = &midi_queue[queue_tail];
+        switch (message->status) {
+            case MIDI_STATUS_NOTE_ON:
+                midi_send_noteon(&midi_device, EC_MIDI_CHANNEL, message->note, message->value);
+                break;
+            case MIDI_STATUS_NOTE_OFF:
+                midi_send_noteoff(&midi_device, EC_MIDI_CHANNEL, message->note, message->value);
+                break;
+            case MIDI_STATUS_AFTERTOUCH:
+                midi_send_aftertouch(&midi_device, EC_MIDI_CHANNEL, message->note, message->value);
+                break;
+            default:
+                break;
+        }
+        queue_tail = (queue_tail + 1) & (EC_MIDI_QUEUE_SIZE - 1);
+    }
+}
+
+// Handle the MIDI commands received over raw HID, returns true if the command was handled
+bool ec_midi_command(uint8_t *data, uint8_t length) {
+    // data = [ command_id, sub_command ]
+    if (data[0] != EC_MIDI_COMMAND_ID) {
+        return false;
+    }
+
+    switch (data[1]) {
+        case EC_MIDI_CMD_DISABLE: {
+            ec_midi_set_enabled(false);
+            break;
+        }
+        case EC_MIDI_CMD_ENABLE: {
+            ec_midi_set_enabled(true);
+            break;
+        }
+        case EC_MIDI_CMD_STATUS: {
+            break;
+        }
+        default: {
+            data[0] = 0xFF; // id_unhandled
+            raw_hid_send(data, length);
+            return true;
+        }
+    }
+
+    // Reply with the current status: [ command_id, sub_command, enabled, key_count, dropped (2 bytes LE) ]
+    data[2] = midi_enabled;
+    data[3] = EC_MIDI_KEY_COUNT;
+    data[4] = queue_dropped & 0xFF;
+    data[5] = queue_dropped >> 8;
+    raw_hid_send(data, length);
+
+    return true;
+}
@@ -0,0 +1,81 @@
+/* Copyright 2026 Cipulot
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "matrix.h"
+
+// Keys played as MIDI notes: { row, col, note } entries, defined by the keymap
+#ifndef EC_MIDI_KEYS
+#    error "EC_MIDI_KEYS must list the MIDI keys as { row, col, note } entries"
+#endif
+
+// Raw HID command id used to control the MIDI mode (outside the range used by VIA)
+#ifndef EC_MIDI_COMMAND_ID
+#    define EC_MIDI_COMMAND_ID 0xE1
+#endif
+
+// MIDI channel of the notes, 0-15
+#ifndef EC_MIDI_CHANNEL
+#    define EC_MIDI_CHANNEL 0
+#endif
+
+// Depth at which a note starts, 0 at rest to 255 at bottom-out
+#ifndef EC_MIDI_NOTE_ON_DEPTH
+#    define EC_MIDI_NOTE_ON_DEPTH 64
+#endif
+
+// Depth below which a started note ends
+#ifndef EC_MIDI_NOTE_OFF_DEPTH
+#    define EC_MIDI_NOTE_OFF_DEPTH 40
+#endif
+
+// Key velocity in counts per ms mapped to the maximum note velocity
+#ifndef EC_MIDI_FULL_VELOCITY
+#    define EC_MIDI_FULL_VELOCITY 96
+#endif
+
+// Minimum change of the aftertouch pressure before a new message is sent
+#ifndef EC_MIDI_AFTERTOUCH_STEP
+#    define EC_MIDI_AFTERTOUCH_STEP 2
+#endif
+
+// Number of MIDI messages waiting for housekeeping, must be a power of two
+#ifndef EC_MIDI_QUEUE_SIZE
+#    define EC_MIDI_QUEUE_SIZE 32
+#endif
+
+_Static_assert((EC_MIDI_QUEUE_SIZE & (EC_MIDI_QUEUE_SIZE - 1)) == 0, "EC_MIDI_QUEUE_SIZE must be a power of two");
+_Static_assert(EC_MIDI_NOTE_OFF_DEPTH < EC_MIDI_NOTE_ON_DEPTH, "EC_MIDI_NOTE_OFF_DEPTH must be below EC_MIDI_NOTE_ON_DEPTH");
+
+// MIDI sub-commands (host to keyboard), data = [ command_id, sub_command ]
+typedef enum {
+    // clang-format off
+    EC_MIDI_CMD_DISABLE = 0x00, // Give the MIDI keys back to the keyboard matrix
+    EC_MIDI_CMD_ENABLE  = 0x01, // Play the MIDI keys as notes
+    EC_MIDI_CMD_STATUS  = 0x02  // Query the MIDI mode status
+    // clang-format on
+} ec_midi_command_t;
+
+void ec_midi_init(void);
+void ec_midi_set_enabled(bool enabled);
+bool ec_midi_enabled(void);
+bool ec_midi_claimed(uint8_t row, uint8_t col);
+void ec_midi_update_key(uint8_t row, uint8_t col, uint8_t depth, int16_t velocity);
+void ec_midi_task(void);
+bool ec_midi_command(uint8_t *data, uint8_t length);
@@ -0,0 +1,240 @@
+/* Copyright 2026 Cipulot
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ec_split.h"
+#include "ec_switch_matrix.h"
+#include "keyboard.h"
+#include "timer.h"
+#include "transactions.h"
+#include <string.h>
+
+// Flags of a config message
+#define EC_SPLIT_FLAG_RESYNC 0x01 // Slave adopts the base version instead of checking it
+
+// Master to slave config message
+typedef struct PACKED {
+    uint16_t base_version;                                    // Version the deltas apply on top of
+    uint8_t  flags;                                           // EC_SPLIT_FLAG_* bits
+    uint8_t  count;                                           // Number of deltas, 0 for a plain verification
+    uint8_t  deltas[EC_SPLIT_MAX_DELTAS][EC_SPLIT_DELTA_SIZE]; // Config deltas
+    uint8_t  checksum;                                        // CRC8 of all the previous fields
+} ec_split_config_msg_t;
+
+// Slave to master config acknowledgement
+typedef struct PACKED {
+    uint16_t version;    // Slave config version after applying the message
+    uint8_t  config_crc; // CRC8 of the slave config state
+    uint8_t  status;     // ec_split_status_t
+} ec_split_config_ack_t;
+
+_Static_assert(sizeof(ec_split_config_msg_t) <= RPC_M2S_BUFFER_SIZE, "EC_SPLIT_MAX_DELTAS doesn't fit in the split RPC buffer");
+
+// Master side state
+static uint8_t  delta_queue[EC_SPLIT_QUEUE_SIZE][EC_SPLIT_DELTA_SIZE];
+static uint8_t  queue_head     = 0;     // Next slot to write
+static uint8_t  queue_count    = 0;     // Deltas waiting for acknowledgement
+static uint16_t acked_version  = 0;     // Slave config version as last acknowledged
+static bool     resync_needed  = false; // Queue overflowed or slave state diverged
+static bool     resync_flag    = false; // Next message carries EC_SPLIT_FLAG_RESYNC
+static uint32_t retry_timer    = 0;     // Time of the last failed transaction
+static uint32_t verify_timer   = 0;     // Time of the last exchange with the slave
+static bool     retry_pending  = false; // Waiting before retrying a failed transaction
+
+// Slave side state
+static uint16_t slave_version = 0;
+
+// Transport statistics
+static ec_split_stats_t stats = {.latency_min_us = UINT16_MAX};
+
+// CRC8 (polynomial 0x07) update
+static uint8_t crc8_update(uint8_t crc, const void *data, size_t length) {
+    const uint8_t *bytes = (const uint8_t *)data;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= bytes[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+// CRC8 of the config state kept in sync between the halves
+static uint8_t config_crc(void) {
+    uint8_t crc = 0;
+    // Indicators
+    crc = crc8_update(crc, &eeprom_ec_config.ind1, sizeof(indicator_config));
+    crc = crc8_update(crc, &eeprom_ec_config.ind2, sizeof(indicator_config));
+    crc = crc8_update(crc, &eeprom_ec_config.ind3, sizeof(indicator_config));
+    // SOCD pairs
+    crc = crc8_update(crc, eeprom_ec_config.eeprom_socd_opposing_pairs, sizeof(eeprom_ec_config.eeprom_socd_opposing_pairs));
+    // Per-key user settings, the calibration data is specific to each half
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            crc = crc8_update(crc, &runtime_ec_config.runtime_key_state[row][col], offsetof(runtime_key_state_t, rescaled_apc_actuation_threshold));
+            // Saved settings, the rescaled thresholds in use derive from them
+            crc = crc8_update(crc, &eeprom_ec_config.eeprom_key_state[row][col], offsetof(eeprom_key_state_t, bottoming_calibration_reading));
+        }
+    }
+    return crc;
+}
+
+// Update the latency statistics with a new round trip
+static void stats_record_latency(uint32_t cycles) {
+    uint32_t latency = EC_CYCLES_TO_US(cycles);
+    if (latency > UINT16_MAX) {
+        latency = UINT16_MAX;
+    }
+    if (latency < stats.latency_min_us) {
+        stats.latency_min_us = latency;
+    }
+    if (latency > stats.latency_max_us) {
+        stats.latency_max_us = latency;
+    }
+    // Exponential moving average, 1/8 weight to the new sample
+    stats.latency_avg_us = stats.transactions ? (uint16_t)((stats.latency_avg_us * 7 + latency) / 8) : (uint16_t)latency;
+    stats.transactions++;
+}
+
+// Slave handler for config messages
+static void config_slave_handler(uint8_t m2s_size, const void *m2s_buffer, uint8_t s2m_size, void *s2m_buffer) {
+    const ec_split_config_msg_t *msg = (const ec_split_config_msg_t *)m2s_buffer;
+    ec_split_config_ack_t       *ack = (ec_split_config_ack_t *)s2m_buffer;
+
+    if (m2s_size != sizeof(ec_split_config_msg_t) || s2m_size != sizeof(ec_split_config_ack_t)) {
+        return;
+    }
+
+    if (crc8_update(0, msg, offsetof(ec_split_config_msg_t, checksum)) != msg->checksum || msg->count > EC_SPLIT_MAX_DELTAS) {
+        ack->status = EC_SPLIT_STATUS_BAD_CHECKSUM;
+    } else {
+        if (msg->flags & EC_SPLIT_FLAG_RESYNC) {
+            slave_version = msg->base_version;
+        }
+        if (msg->base_version != slave_version) {
+            ack->status = EC_SPLIT_STATUS_VERSION_MISMATCH;
+        } else {
+            // Apply the deltas in order
+            for (uint8_t i = 0; i < msg->count; i++) {
+                uint8_t delta[EC_SPLIT_DELTA_SIZE];
+                memcpy(delta, msg->deltas[i], EC_SPLIT_DELTA_SIZE);
+                ec_split_apply_config(delta);
+            }
+            slave_version += msg->count;
+            ack->status = EC_SPLIT_STATUS_OK;
+        }
+    }
+
+    ack->version    = slave_version;
+    ack->config_crc = config_crc();
+}
+
+// Register the slave handlers
+void ec_split_init(void) {
+    transaction_register_rpc(RPC_ID_EC_CONFIG_SYNC, config_slave_handler);
+}
+
+// Master: queue a VIA set command for the slave
+void ec_split_queue_config(const uint8_t *value_id_and_data) {
+    if (queue_count >= EC_SPLIT_QUEUE_SIZE) {
+        // Too many changes in flight, the full state will be sent instead
+        resync_needed = true;
+        return;
+    }
+    memcpy(delta_queue[queue_head], value_id_and_data, EC_SPLIT_DELTA_SIZE);
+    queue_head = (queue_head + 1) % EC_SPLIT_QUEUE_SIZE;
+    queue_count++;
+}
+
+// Master: drop the pending deltas and queue the full current state
+static void start_resync(void) {
+    queue_count   = 0;
+    resync_needed = false;
+    resync_flag   = true;
+    stats.resyncs++;
+    ec_split_queue_config_snapshot();
+}
+
+// Master: send a batch of pending deltas (or a plain verification) and process the acknowledgement
+static void config_exchange(void) {
+    ec_split_config_msg_t msg;
+    ec_split_config_ack_t ack;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.base_version = acked_version;
+    msg.flags        = resync_flag ? EC_SPLIT_FLAG_RESYNC : 0;
+    msg.count        = MIN(queue_count, EC_SPLIT_MAX_DELTAS);
+    // Oldest deltas first
+    uint8_t tail = (queue_head + EC_SPLIT_QUEUE_SIZE - queue_count) % EC_SPLIT_QUEUE_SIZE;
+    for (uint8_t i = 0; i < msg.count; i++) {
+        memcpy(msg.deltas[i], delta_queue[(tail + i) % EC_SPLIT_QUEUE_SIZE], EC_SPLIT_DELTA_SIZE);
+    }
+    msg.checksum = crc8_update(0, &msg, offsetof(ec_split_config_msg_t, checksum));
+
+    uint32_t start = ec_cycle_count();
+    if (!transaction_rpc_exec(RPC_ID_EC_CONFIG_SYNC, sizeof(msg), &msg, sizeof(ack), &ack)) {
+        stats.failures++;
+        retry_pending = true;
+        retry_timer   = timer_read32();
+        return;
+    }
+    stats_record_latency(ec_cycle_count() - start);
+    retry_pending = false;
+    verify_timer  = timer_read32();
+
+    switch (ack.status) {
+        case EC_SPLIT_STATUS_OK:
+            queue_count  -= msg.count;
+            acked_version = ack.version;
+            resync_flag   = false;
+            // All caught up: the slave state must match the local one
+            if (queue_count == 0 && ack.config_crc != config_crc()) {
+                resync_needed = true;
+            }
+            break;
+        case EC_SPLIT_STATUS_VERSION_MISMATCH:
+            resync_needed = true;
+            break;
+        case EC_SPLIT_STATUS_BAD_CHECKSUM:
+        default:
+            // Deltas stay queued and are sent again
+            break;
+    }
+}
+
+// Master: split transport housekeeping
+void ec_split_task(void) {
+    if (!is_keyboard_master()) {
+        return;
+    }
+
+    if (retry_pending && timer_elapsed32(retry_timer) < EC_SPLIT_RETRY_INTERVAL) {
+        return;
+    }
+
+    if (resync_needed) {
+        start_resync();
+    }
+
+    // Send pending deltas right away, otherwise verify the slave state from time to time
+    if (queue_count || resync_flag || timer_elapsed32(verify_timer) >= EC_SPLIT_VERIFY_INTERVAL) {
+        config_exchange();
+    }
+}
+
+// Get the transport statistics
+const ec_split_stats_t *ec_split_get_stats(void) {
+    return &stats;
+}
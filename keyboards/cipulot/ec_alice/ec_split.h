@@ -0,0 +1,72 @@
+/* Copyright 2026 Cipulot
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Size of a config delta: [ value_id, value_data[0], value_data[1] ]
+#define EC_SPLIT_DELTA_SIZE 3
+
+// Maximum number of deltas batched in a single transaction
+#ifndef EC_SPLIT_MAX_DELTAS
+#    define EC_SPLIT_MAX_DELTAS 8
+#endif
+
+// Number of deltas that can wait for transmission before falling back to a full resync,
+// must hold at least a full config snapshot
+#ifndef EC_SPLIT_QUEUE_SIZE
+#    define EC_SPLIT_QUEUE_SIZE 48
+#endif
+
+// Time between retries of a failed transaction in ms
+#ifndef EC_SPLIT_RETRY_INTERVAL
+#    define EC_SPLIT_RETRY_INTERVAL 10
+#endif
+
+// Time between two state verifications when no delta is pending in ms
+#ifndef EC_SPLIT_VERIFY_INTERVAL
+#    define EC_SPLIT_VERIFY_INTERVAL 1000
+#endif
+
+// Slave reply status
+typedef enum {
+    // clang-format off
+    EC_SPLIT_STATUS_OK               = 0, // Deltas applied
+    EC_SPLIT_STATUS_BAD_CHECKSUM     = 1, // Message corrupted, nothing applied
+    EC_SPLIT_STATUS_VERSION_MISMATCH = 2  // Slave missed deltas, resync needed
+    // clang-format on
+} ec_split_status_t;
+
+// Transport statistics, latencies in us
+typedef struct {
+    uint32_t transactions;   // Completed round trips
+    uint32_t failures;       // Failed transactions
+    uint16_t resyncs;        // Full resyncs triggered
+    uint16_t latency_min_us; // Minimum round trip latency
+    uint16_t latency_max_us; // Maximum round trip latency
+    uint16_t latency_avg_us; // Moving average of the round trip latency
+} ec_split_stats_t;
+
+void                    ec_split_init(void);
+void                    ec_split_task(void);
+void                    ec_split_queue_config(const uint8_t *value_id_and_data);
+const ec_split_stats_t *ec_split_get_stats(void);
+
+// Implemented by the VIA layer
+void ec_split_apply_config(uint8_t *value_id_and_data); // Apply a received delta on the slave
+void ec_split_queue_config_snapshot(void);              // Queue the full current config on the master
@@ -17,11 +17,32 @@
 #include "ec_switch_matrix.h"
 #include "analog.h"
 #include "atomic_util.h"
+#include "ec_log.h"
 #include "math.h"
-#include "print.h"
+#include "timer.h"
 #include "wait.h"
 #include <string.h>
 
+#ifdef EC_ANALOG_STREAM_ENABLE
+#    include "ec_analog_stream.h"
+#endif
+
+#ifdef EC_MIDI_ENABLE
+#    include "ec_midi.h"
+#endif
+
+#ifdef EC_TRAVEL_THRESHOLDS_MM
+#    include "ec_travel.h"
+#endif
+
+#ifdef EC_WS2812_SCHEDULED
+#    include "ec_ws2812.h"
+#endif
+
+#ifdef EC_ANALOG_MOUSE_ENABLE
+#    include "ec_analog_mouse.h"
+#endif
+
 #if defined(__AVR__)
 #    error "AVR platforms not supported due to a variety of reasons. Among them there are limited memory, limited number of pins and ADC not being able to give satisfactory results."
 #endif
@@ -39,6 +60,9 @@ const pin_t amux_sel_pins[]                            = AMUX_SEL_PINS;
 const pin_t amux_en_pins[]                             = AMUX_EN_PINS;
 const pin_t amux_n_col_sizes[]                         = AMUX_COL_CHANNELS_SIZES;
 const pin_t amux_n_col_channels[][AMUX_MAX_COLS_COUNT] = {AMUX_COL_CHANNELS};
+#ifdef ANALOG_PORTS
+const pin_t analog_ports[] = ANALOG_PORTS;
+#endif
 
 // Define unused positions array if specified
 #ifdef UNUSED_POSITIONS_LIST
@@ -57,12 +81,86 @@ _Static_assert(ARRAY_SIZE(amux_en_pins) == AMUX_COUNT, "AMUX_EN_PINS doesn't hav
 _Static_assert(AMUX_SEL_PINS_COUNT == EXPECTED_AMUX_SEL_PINS_COUNT, "AMUX_SEL_PINS doesn't have the minimum number of bits required address all the channels");
 // Check that number of elements in AMUX_COL_CHANNELS_SIZES is enough to specify the number of channels for all the multiplexers available
 _Static_assert(ARRAY_SIZE(amux_n_col_sizes) == AMUX_COUNT, "AMUX_COL_CHANNELS_SIZES doesn't have the minimum number of elements required to specify the number of channels for all the multiplexers available");
+#ifdef ANALOG_PORTS
+// Check that every AMUX has its own analog input
+_Static_assert(ARRAY_SIZE(analog_ports) == AMUX_COUNT, "ANALOG_PORTS doesn't have one analog input for each of the multiplexers available");
+// Check that the regular sequence can hold all the analog inputs
+_Static_assert(AMUX_COUNT <= 16, "ANALOG_PORTS has more analog inputs than the ADC regular sequence can hold");
+#    ifndef ADC_SQR3_SQ1_N
+#        error "ANALOG_PORTS builds its regular sequence for the STM32F2/F4/F7 ADC"
+#    endif
+#endif
 
 // Matrix switch value storage
 static uint16_t sw_value[MATRIX_ROWS][MATRIX_COLS];
 
+#ifdef ANALOG_PORTS
+// ADC multiplexer instances, one per AMUX
+static adc_mux adcMuxes[AMUX_COUNT];
+#    define EC_ADC_MUXES adcMuxes
+#    define EC_ADC_MUX(channel) adcMuxes[channel]
+#    define EC_ADC_INPUTS AMUX_COUNT
+
+// Regular sequence converting the analog inputs of every AMUX in one go, completed in ec_init
+static ADCConversionGroup scanGroup = {
+    .num_channels = AMUX_COUNT,
+    .cr1          = EC_SCAN_RESOLUTION,
+    .cr2          = ADC_CR2_SWSTART,
+};
+
+// Number of channels the selection pins address
+#    define AMUX_CHANNEL_COUNT (1 << AMUX_SEL_PINS_COUNT)
+// Marker for a channel without a column
+#    define AMUX_NO_COL 0xFF
+// Column of each AMUX on each channel, built in ec_init
+static uint8_t amux_channel_cols[AMUX_COUNT][AMUX_CHANNEL_COUNT];
+#else
 // ADC multiplexer instance
 static adc_mux adcMux;
+#    define EC_ADC_MUXES (&adcMux)
+#    define EC_ADC_MUX(channel) adcMux
+#    define EC_ADC_INPUTS 1
+#endif
+
+#ifdef EC_TWO_TIER_SCAN_ENABLE
+// Fast low resolution conversion used to triage the keys, completed in ec_init
+static ADCConversionGroup coarseGroup = {
+    .num_channels = EC_ADC_INPUTS,
+    .cr1          = EC_COARSE_RESOLUTION,
+    .cr2          = ADC_CR2_SWSTART,
+};
+static bool    coarse_reading    = false; // Reading being processed comes from the coarse pass
+static uint8_t coarse_scan_count = 0;     // Scans since the last full precision one
+#endif
+
+#ifdef EC_VREFINT_ENABLE
+// Internal reference, sampled to follow the analog supply voltage with its own long sampling time, completed in ec_init
+static ADCConversionGroup vrefintGroup = {
+    .num_channels = 1,
+    .cr1          = EC_ADC_CR1_RESOLUTION,
+    .cr2          = ADC_CR2_SWSTART,
+};
+static uint16_t vrefint_cal;                      // Factory VREFINT reading at EC_VREFINT_CAL_VDDA, in switch reading resolution
+static uint32_t vrefint_filtered;                 // Filtered VREFINT reading, Q4
+static uint32_t vdda_scale   = (uint32_t)1 << 15; // Reading correction factor, Q15
+static uint16_t vrefint_time = 0;                 // Time of the last VREFINT sample
+#endif
+
+static inline uint16_t ec_readkey(uint8_t channel, uint8_t row, uint8_t col, bool coarse);
+#ifdef ANALOG_PORTS
+static inline void ec_readkeys(uint8_t row, uint16_t values[], bool coarse);
+#endif
+static inline void ec_update_key_velocity(runtime_key_state_t *key_runtime, uint16_t sw_value);
+
+#ifdef EC_IDLE_SCAN_ENABLE
+// Idle scan mode state
+static bool                 idle_scan           = false; // Scanning at the reduced rate
+static bool                 idle_scan_requested = false; // Reduced rate requested from outside, e.g. by the idle manager
+static uint32_t             idle_quiet_timer    = 0;     // Time of the last reading outside the noise band
+static uint32_t             idle_scan_start     = 0;     // Cycle count at the start of the current idle scan
+static uint32_t             idle_prev_start     = 0;     // Cycle count at the start of the previous idle scan
+static ec_idle_scan_stats_t idle_scan_stats;
+#endif
 
 // Initialize the row pins
 void init_row(void) {
@@ -74,7 +172,7 @@ void init_row(void) {
 }
 
 // Disable all the unused rows
-void disable_unused_row(uint8_t row) {
+EC_SCAN_HOT void disable_unused_row(uint8_t row) {
     // disable all the other rows apart from the current selected one
     for (uint8_t idx = 0; idx < MATRIX_ROWS; idx++) {
         if (idx != row) {
@@ -97,7 +195,7 @@ void init_amux(void) {
 }
 
 // Select the AMUX channel
-void select_amux_channel(uint8_t channel, uint8_t col) {
+EC_SCAN_HOT void select_amux_channel(uint8_t channel, uint8_t col) {
     // Get the channel to select
     uint8_t ch = amux_n_col_channels[channel][col];
     // Disable the AMUX before changing the selection
@@ -110,8 +208,32 @@ void select_amux_channel(uint8_t channel, uint8_t col) {
     gpio_write_pin_low(amux_en_pins[channel]);
 }
 
+#ifdef ANALOG_PORTS
+// Select the same channel on every AMUX that has a column on it, the others stay disabled
+// Returns false if no AMUX uses the channel
+EC_SCAN_HOT static bool select_amux_channel_all(uint8_t ch) {
+    bool used = false;
+    // Disable all the AMUXs before changing the selection
+    for (uint8_t idx = 0; idx < AMUX_COUNT; idx++) {
+        gpio_write_pin_high(amux_en_pins[idx]);
+    }
+    // Set the selection pins
+    for (uint8_t i = 0; i < AMUX_SEL_PINS_COUNT; i++) {
+        gpio_write_pin(amux_sel_pins[i], ch & (1 << i));
+    }
+    // Enable the AMUXs with a column on the channel
+    for (uint8_t idx = 0; idx < AMUX_COUNT; idx++) {
+        if (amux_channel_cols[idx][ch] != AMUX_NO_COL) {
+            gpio_write_pin_low(amux_en_pins[idx]);
+            used = true;
+        }
+    }
+    return used;
+}
+#endif
+
 // Disable all the unused AMUXs
-void disable_unused_amux(uint8_t channel) {
+EC_SCAN_HOT void disable_unused_amux(uint8_t channel) {
     // disable all the other AMUXs apart from the current selected one
     for (uint8_t idx = 0; idx < AMUX_COUNT; idx++) {
         if (idx != channel) {
@@ -121,7 +243,7 @@ void disable_unused_amux(uint8_t channel) {
 }
 
 // Charge the peak hold capacitor
-void charge_capacitor(uint8_t row) {
+EC_SCAN_HOT void charge_capacitor(uint8_t row) {
     // Set the row pin to high state to charge the capacitor
 #ifdef OPEN_DRAIN_SUPPORT
     gpio_write_pin_high(DISCHARGE_PIN);
@@ -131,8 +253,11 @@ void charge_capacitor(uint8_t row) {
     gpio_write_pin_high(row_pins[row]);
 }
 
+// Cycle count at the start of the last peak hold capacitor discharge
+static uint32_t discharge_start = 0;
+
 // Discharge the peak hold capacitor
-void discharge_capacitor(void) {
+EC_SCAN_HOT void discharge_capacitor(void) {
     // Set the discharge pin to low state to discharge the capacitor
 #ifdef OPEN_DRAIN_SUPPORT
     gpio_write_pin_low(DISCHARGE_PIN);
@@ -140,16 +265,433 @@ void discharge_capacitor(void) {
     gpio_write_pin_low(DISCHARGE_PIN);
     gpio_set_pin_output(DISCHARGE_PIN);
 #endif
+    discharge_start = ec_cycle_count();
+}
+
+// Wait for the end of the last discharge, the time spent since its start doesn't need to be waited again
+EC_SCAN_HOT static inline void ec_discharge_wait(void) {
+    while (ec_cycle_count() - discharge_start < EC_US_TO_CYCLES(DISCHARGE_TIME)) {
+    }
+}
+
+#ifdef EC_VREFINT_ENABLE
+// Sample the internal reference and update the reading correction factor
+static void ec_vrefint_sample(bool reset) {
+    adcsample_t sample = 0;
+    adcConvert(&ADCD1, &vrefintGroup, &sample, 1);
+    uint32_t reading = (uint32_t)sample << 4;
+    if (reset) {
+        vrefint_filtered = reading;
+    } else {
+        vrefint_filtered += ((int32_t)reading - (int32_t)vrefint_filtered) / (1 << EC_VREFINT_FILTER_SHIFT);
+    }
+    // A lower VDDA raises the VREFINT reading, scale the switch readings back to the factory VDDA
+    if (vrefint_filtered) {
+        vdda_scale = ((uint32_t)vrefint_cal << 19) / vrefint_filtered;
+    }
+}
+
+// Normalize a switch reading to the factory VDDA, fixed point
+static inline uint16_t ec_vdda_normalize(uint16_t sw_value) {
+    return MIN((sw_value * vdda_scale) >> 15, EC_ADC_MAX);
+}
+
+// Get the analog supply voltage in mV, from the filtered VREFINT reading
+uint16_t ec_get_vdda_mv(void) {
+    return vrefint_filtered ? ((uint32_t)EC_VREFINT_CAL_VDDA * vrefint_cal << 4) / vrefint_filtered : 0;
+}
+#endif
+
+#ifdef EC_TEMP_COMPENSATION_ENABLE
+// Temperature sensor, converted with its own long sampling time, completed in ec_init
+static ADCConversionGroup tempGroup = {
+    .num_channels = 1,
+    .cr1          = EC_ADC_CR1_RESOLUTION,
+    .cr2          = ADC_CR2_SWSTART,
+};
+static int16_t  temp_ref     = 0;     // Temperature of the noise floor calibration, 0.1 degree
+static int32_t  temp_now     = 0;     // Filtered temperature, 0.1 degree Q4
+static bool     temp_started = false; // Reference temperature and base floors set
+static uint16_t temp_time    = 0;     // Time of the last temperature sample
+
+// Read the internal temperature sensor, in 0.1 degree
+static int16_t ec_temp_read(void) {
+    adcsample_t sample = 0;
+    adcConvert(&ADCD1, &tempGroup, &sample, 1);
+    int32_t reading = sample;
+#    ifdef EC_VREFINT_ENABLE
+    reading = ec_vdda_normalize(reading);
+#    endif
+    int32_t cal1 = *(const uint16_t *)EC_TEMP_CAL1_ADDR;
+    int32_t cal2 = *(const uint16_t *)EC_TEMP_CAL2_ADDR;
+    return 300 + ((reading << EC_TEMP_CAL_SHIFT) - cal1) * 800 / (cal2 - cal1);
+}
+
+// Resting level change of a key predicted by its fitted drift, in counts
+static int16_t ec_temp_predicted_offset(runtime_key_state_t *key_runtime, int16_t offset) {
+    // Only extrapolate away from the reference, and only from a fit that saw offsets of that size
+    if ((offset < 0 ? -offset : offset) < EC_TEMP_FIT_MIN_SPAN || key_runtime->temp_sw == 0) {
+        return 0;
+    }
+    if (((int64_t)key_runtime->temp_sxx << 8) / key_runtime->temp_sw < EC_TEMP_FIT_MIN_SPAN * EC_TEMP_FIT_MIN_SPAN) {
+        return 0;
+    }
+    return (int64_t)key_runtime->temp_sxy * offset / key_runtime->temp_sxx / 16;
+}
+
+// Sample the temperature, fit the per-key drift on resting keys and move the noise floors ahead of it
+static void ec_temp_task(matrix_row_t current_matrix[]) {
+    int16_t temp = ec_temp_read();
+    temp_now += (((int32_t)temp << 4) - temp_now) / (1 << EC_TEMP_FILTER_SHIFT);
+
+    if (!temp_started) {
+        // The noise floor calibration defines the reference
+        temp_now     = (int32_t)temp << 4;
+        temp_ref     = temp;
+        temp_started = true;
+        for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+            for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+                runtime_ec_config.runtime_key_state[row][col].temp_base_floor = runtime_ec_config.runtime_key_state[row][col].noise_floor;
+            }
+        }
+        return;
+    }
+
+    int16_t offset = (temp_now >> 4) - temp_ref;
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            runtime_key_state_t *key_runtime = &runtime_ec_config.runtime_key_state[row][col];
+            eeprom_key_state_t  *key_eeprom  = &eeprom_ec_config.eeprom_key_state[row][col];
+
+            // Fit the drift from the resting level, only known while the key rests
+            if (!(current_matrix[row] & (1 << col)) && key_runtime->noise_count >= EC_NOISE_REFRESH) {
+                int32_t level = (int32_t)(key_runtime->noise_mean >> 4) - ((int32_t)key_runtime->temp_base_floor << 4);
+                key_runtime->temp_sxx += offset * offset - key_runtime->temp_sxx / (1 << EC_TEMP_FIT_SHIFT);
+                key_runtime->temp_sxy += offset * level - key_runtime->temp_sxy / (1 << EC_TEMP_FIT_SHIFT);
+                key_runtime->temp_sw += (1 << 8) - key_runtime->temp_sw / (1 << EC_TEMP_FIT_SHIFT);
+            }
+
+            // Apply the predicted resting level, also while the key is held
+            int32_t predicted_floor = MAX(key_runtime->temp_base_floor + ec_temp_predicted_offset(key_runtime, offset), 0);
+            if (predicted_floor != key_runtime->noise_floor) {
+                key_runtime->noise_floor = predicted_floor;
+                bulk_rescale_key_thresholds(key_runtime, key_eeprom, RESCALE_MODE_ALL);
+            }
+        }
+    }
+}
+
+// Get the filtered MCU temperature in 0.1 degree
+int16_t ec_get_temperature(void) {
+    return temp_now >> 4;
+}
+
+// Get the fitted drift of a key in 1/16 count per degree
+int16_t ec_get_key_temp_drift(uint8_t row, uint8_t col) {
+    runtime_key_state_t *key_runtime = &runtime_ec_config.runtime_key_state[row][col];
+    if (key_runtime->temp_sxx == 0) {
+        return 0;
+    }
+    return MAX(MIN((int64_t)key_runtime->temp_sxy * 10 / key_runtime->temp_sxx, INT16_MAX), INT16_MIN);
+}
+#endif
+
+#ifdef EC_SOF_SYNC_ENABLE
+#    define EC_SOF_PERIOD EC_US_TO_CYCLES(1000)
+
+static bool           sof_locked      = false; // Start of frame edge known
+static bool           sof_aligned     = false; // Current scan aligned to a start of frame
+static uint32_t       sof_edge        = 0;     // Cycle count of the last measured start of frame
+static uint32_t       sof_scan_cycles = 0;     // Filtered scan duration in cycles
+static uint32_t       sof_scan_start  = 0;     // Cycle count at the start of the current scan
+static uint32_t       sof_target      = 0;     // Start of frame the current scan should end before
+static uint16_t       sof_resync_time = 0;     // Time of the last edge measurement
+static ec_sof_stats_t sof_stats       = {.lead_min_us = UINT16_MAX};
+
+// Frame number of the last start of frame, updated by the USB core
+static inline uint16_t ec_sof_frame(void) {
+    return (OTG_FS->DSTS >> 8) & 0x3FFF;
+}
+
+// Measure the start of frame edge, busy waits up to one frame
+static void ec_sof_resync(void) {
+    uint16_t frame = ec_sof_frame();
+    uint32_t start = ec_cycle_count();
+    while (ec_sof_frame() == frame) {
+        // No frame in 2 ms: USB is not running, scan freely
+        if (ec_cycle_count() - start > 2 * EC_SOF_PERIOD) {
+            sof_locked = false;
+            return;
+        }
+    }
+    uint32_t edge = ec_cycle_count();
+
+    if (sof_locked) {
+        // Distance to the nearest predicted edge
+        uint32_t phase = (edge - sof_edge) % EC_SOF_PERIOD;
+        uint32_t error = MIN(phase, EC_SOF_PERIOD - phase);
+        sof_stats.phase_error_us     = MIN(EC_CYCLES_TO_US(error), UINT16_MAX);
+        sof_stats.phase_error_max_us = MAX(sof_stats.phase_error_max_us, sof_stats.phase_error_us);
+    }
+    sof_edge   = edge;
+    sof_locked = true;
+    sof_stats.resyncs++;
+}
+
+// Hold the scan start so the scan ends EC_SOF_LEAD_US before the next start of frame
+static void ec_sof_align(void) {
+    // Also rate limited without a lock: with no start of frame (split slave, before enumeration, suspended) every attempt busy waits two frames
+    if (timer_elapsed(sof_resync_time) >= EC_SOF_RESYNC_INTERVAL) {
+        ec_sof_resync();
+        sof_resync_time = timer_read();
+    }
+    if (!sof_locked) {
+        sof_aligned = false;
+        return;
+    }
+
+    // Phase in the frame at which the scan has to start
+    uint32_t end_phase   = EC_SOF_PERIOD - EC_US_TO_CYCLES(EC_SOF_LEAD_US);
+    uint32_t start_phase = (end_phase + EC_SOF_PERIOD - sof_scan_cycles % EC_SOF_PERIOD) % EC_SOF_PERIOD;
+    uint32_t now         = ec_cycle_count();
+    uint32_t phase       = (now - sof_edge) % EC_SOF_PERIOD;
+    uint32_t wait        = (start_phase + EC_SOF_PERIOD - phase) % EC_SOF_PERIOD;
+
+    while (ec_cycle_count() - now < wait) {
+    }
+    sof_scan_start = ec_cycle_count();
+    sof_aligned    = true;
+
+    // First start of frame after the expected end of the scan
+    uint32_t expected_end = sof_scan_start + sof_scan_cycles;
+    sof_target            = expected_end + (EC_SOF_PERIOD - (expected_end - sof_edge) % EC_SOF_PERIOD) % EC_SOF_PERIOD;
+}
+
+// Record the scan duration and its distance to the target start of frame
+static void ec_sof_scan_done(void) {
+    if (!sof_aligned) {
+        return;
+    }
+    sof_aligned = false;
+
+    uint32_t end      = ec_cycle_count();
+    uint32_t duration = end - sof_scan_start;
+    sof_scan_cycles   = sof_scan_cycles ? sof_scan_cycles + ((int32_t)(duration - sof_scan_cycles) >> EC_SOF_FILTER_SHIFT) : duration;
+
+    sof_stats.scans++;
+    sof_stats.scan_avg_us = MIN(EC_CYCLES_TO_US(sof_scan_cycles), UINT16_MAX);
+    sof_stats.scan_max_us = MAX(sof_stats.scan_max_us, MIN(EC_CYCLES_TO_US(duration), UINT16_MAX));
+
+    int32_t lead = (int32_t)(sof_target - end);
+    if (lead < 0) {
+        sof_stats.late++;
+    } else {
+        uint16_t lead_us      = MIN(EC_CYCLES_TO_US((uint32_t)lead), UINT16_MAX);
+        sof_stats.lead_min_us = MIN(sof_stats.lead_min_us, lead_us);
+        sof_stats.lead_avg_us = sof_stats.lead_avg_us + ((int32_t)lead_us - sof_stats.lead_avg_us) / (1 << EC_SOF_FILTER_SHIFT);
+    }
+}
+
+// Get the start of frame lock statistics
+const ec_sof_stats_t *ec_sof_get_stats(void) {
+    return &sof_stats;
+}
+#endif
+
+#ifdef EC_FIXED_RATE_SCAN_ENABLE
+_Static_assert(EC_SCAN_INTERVAL_US > 0 && EC_SCAN_INTERVAL_US <= UINT16_MAX, "EC_SCAN_INTERVAL_US must fit the 16 bit scan timer");
+
+// Fixed rate scan state, the tick fields are shared with the scan timer interrupt
+static volatile bool         fixed_rate_tick      = false; // Scan timer fired since the last scan start
+static volatile uint32_t     fixed_rate_tick_time = 0;     // Cycle count at the last scan timer tick
+static volatile uint32_t     fixed_rate_missed    = 0;     // Ticks that fired while the previous one was still pending
+static bool                  fixed_rate_running   = false; // Previous scan was started by the scan timer
+static uint32_t              fixed_rate_start     = 0;     // Cycle count at the start of the previous scan
+static ec_fixed_rate_stats_t fixed_rate_stats     = {.interval_min_us = UINT16_MAX};
+
+// Scan timer tick, runs in interrupt context
+static void ec_fixed_rate_tick(GPTDriver *gptp) {
+    (void)gptp;
+    if (fixed_rate_tick) {
+        fixed_rate_missed++;
+    }
+    fixed_rate_tick_time = ec_cycle_count();
+    fixed_rate_tick      = true;
+}
+
+// Scan timer counting in us
+static const GPTConfig fixed_rate_gpt_config = {
+    .frequency = 1000000,
+    .callback  = ec_fixed_rate_tick,
+    .cr2       = 0,
+    .dier      = 0,
+};
+
+// Sleep in WFI until the scan timer starts the next scan
+static void ec_fixed_rate_wait(void) {
+    // Interrupts stay masked between the check and WFI so a tick can't slip in between, a pending one still ends WFI
+    __disable_irq();
+    while (!fixed_rate_tick) {
+        __WFI();
+        __enable_irq();
+        __disable_irq();
+    }
+    uint32_t tick_time = fixed_rate_tick_time;
+    uint32_t missed    = fixed_rate_missed;
+    fixed_rate_tick    = false;
+    fixed_rate_missed  = 0;
+    __enable_irq();
+
+    uint32_t start = ec_cycle_count();
+    fixed_rate_stats.scans++;
+    fixed_rate_stats.overruns += missed;
+    fixed_rate_stats.wake_latency_us     = MIN(EC_CYCLES_TO_US(start - tick_time), UINT16_MAX);
+    fixed_rate_stats.wake_latency_max_us = MAX(fixed_rate_stats.wake_latency_max_us, fixed_rate_stats.wake_latency_us);
+
+    if (fixed_rate_running) {
+        uint16_t interval                = MIN(EC_CYCLES_TO_US(start - fixed_rate_start), UINT16_MAX);
+        fixed_rate_stats.interval_min_us = MIN(fixed_rate_stats.interval_min_us, interval);
+        fixed_rate_stats.interval_max_us = MAX(fixed_rate_stats.interval_max_us, interval);
+        fixed_rate_stats.jitter_us       = fixed_rate_stats.interval_max_us - fixed_rate_stats.interval_min_us;
+    }
+    fixed_rate_start   = start;
+    fixed_rate_running = true;
+}
+
+#    ifdef EC_IDLE_SCAN_ENABLE
+// Drop the pending tick while the idle scan mode sets the pace
+static void ec_fixed_rate_pause(void) {
+    __disable_irq();
+    fixed_rate_tick   = false;
+    fixed_rate_missed = 0;
+    __enable_irq();
+    fixed_rate_running = false;
+}
+#    endif
+
+// Get the fixed rate scan statistics
+const ec_fixed_rate_stats_t *ec_fixed_rate_get_stats(void) {
+    return &fixed_rate_stats;
+}
+#endif
+
+#ifdef EC_TWO_TIER_SCAN_ENABLE
+// Scale a coarse sample to the switch reading resolution, centered in its coarse step
+#    define EC_COARSE_TO_READING(sample) (((uint16_t)(sample) << EC_COARSE_SHIFT) + ((1 << EC_COARSE_SHIFT) >> 1))
+
+// Convert the peak hold voltage with the coarse conversion, scaled to the switch reading resolution
+static inline uint16_t ec_adc_read_coarse(void) {
+    adcsample_t sample = 0;
+    // The switch readings all come from ADC1
+    adcConvert(&ADCD1, &coarseGroup, &sample, 1);
+    return EC_COARSE_TO_READING(sample);
 }
 
+// Check if a coarse reading lands close enough to a decision to need a full precision read
+static inline bool ec_key_needs_fine_read(runtime_key_state_t *key_runtime, uint16_t coarse) {
+#    ifdef EC_ONLINE_CALIBRATION_ENABLE
+    // Follow the strokes tracked by the online calibration at full precision, from the start to the end
+    if (key_runtime->stroke_peak || coarse + EC_COARSE_GUARD_BAND > key_runtime->noise_floor + BOTTOMING_CALIBRATION_THRESHOLD) {
+        return true;
+    }
+#    endif
+    if (key_runtime->actuation_mode == 0) {
+        // Close to one of the APC thresholds
+        uint16_t actuation = key_runtime->rescaled_apc_actuation_threshold;
+        uint16_t release   = key_runtime->rescaled_apc_release_threshold;
+        return (coarse + EC_COARSE_GUARD_BAND >= actuation && coarse <= actuation + EC_COARSE_GUARD_BAND) || (coarse + EC_COARSE_GUARD_BAND >= release && coarse <= release + EC_COARSE_GUARD_BAND);
+    }
+    // Inside or close to the Rapid Trigger active zone, every step counts there
+    return coarse + EC_COARSE_GUARD_BAND > key_runtime->rescaled_rt_initial_deadzone_offset;
+}
+#endif
+
+#if defined(ANALOG_PORTS) || defined(EC_TWO_TIER_SCAN_ENABLE) || defined(EC_VREFINT_ENABLE) || defined(EC_TEMP_COMPENSATION_ENABLE)
+// Program the sampling time and the regular sequence of a conversion group over the given inputs
+static void ec_adc_group_init(ADCConversionGroup *group, const adc_mux *inputs, uint32_t sampling_time) {
+    for (uint8_t i = 0; i < group->num_channels; i++) {
+        uint8_t input = inputs[i].input;
+        // Sampling time, 3 bits per input
+        if (input < 10) {
+            group->smpr2 |= sampling_time << (3 * input);
+        } else {
+            group->smpr1 |= sampling_time << (3 * (input - 10));
+        }
+        // Sequence position, 5 bits per position and six positions per register
+        if (i < 6) {
+            group->sqr3 |= (uint32_t)input << (5 * i);
+        } else if (i < 12) {
+            group->sqr2 |= (uint32_t)input << (5 * (i - 6));
+        } else {
+            group->sqr1 |= (uint32_t)input << (5 * (i - 12));
+        }
+    }
+    group->sqr1 |= ADC_SQR1_NUM_CH(group->num_channels);
+}
+#endif
+
 // Initialize the EC switch matrix
 int ec_init(void) {
     // Initialize the ADC peripheral
+#ifdef ANALOG_PORTS
+    // One analog input per AMUX
+    for (uint8_t idx = 0; idx < AMUX_COUNT; idx++) {
+        palSetLineMode(analog_ports[idx], PAL_MODE_INPUT_ANALOG);
+        adcMuxes[idx] = pinToMux(analog_ports[idx]);
+    }
+    ec_adc_group_init(&scanGroup, adcMuxes, EC_SCAN_SAMPLING_TIME);
+
+    // Map the AMUX channels back to their columns
+    memset(amux_channel_cols, AMUX_NO_COL, sizeof(amux_channel_cols));
+    for (uint8_t amux = 0; amux < AMUX_COUNT; amux++) {
+        for (uint8_t col = 0; col < amux_n_col_sizes[amux]; col++) {
+            amux_channel_cols[amux][amux_n_col_channels[amux][col]] = col;
+        }
+    }
+#else
     palSetLineMode(ANALOG_PORT, PAL_MODE_INPUT_ANALOG);
     adcMux = pinToMux(ANALOG_PORT);
+#endif
 
     // Dummy call to make sure that adcStart() has been called in the appropriate state
-    adc_read(adcMux);
+    adc_read(EC_ADC_MUX(0));
+
+#ifdef EC_TWO_TIER_SCAN_ENABLE
+    // Point the coarse conversion at the switch reading inputs
+    ec_adc_group_init(&coarseGroup, EC_ADC_MUXES, EC_COARSE_SAMPLING_TIME);
+#endif
+
+#ifdef EC_TRAVEL_THRESHOLDS_MM
+    // Build the reading to travel table of the Rapid Trigger modes
+    ec_travel_init();
+#endif
+
+#ifdef EC_TEMP_COMPENSATION_ENABLE
+    // Route the temperature sensor to the ADC, sampled once the noise floor is known
+    adcSTM32EnableTSVREFE();
+    adc_mux temp_input = TO_MUX(EC_TEMP_SENSOR_CHANNEL, 0);
+    ec_adc_group_init(&tempGroup, &temp_input, EC_TEMP_SAMPLING_TIME);
+#endif
+
+#ifdef EC_VREFINT_ENABLE
+    // Route the internal reference to the ADC and take its first sample
+    adcSTM32EnableTSVREFE();
+    adc_mux vrefint_input = TO_MUX(ADC_CHANNEL_VREFINT, 0);
+    ec_adc_group_init(&vrefintGroup, &vrefint_input, EC_VREFINT_SAMPLING_TIME);
+    vrefint_cal = *(const uint16_t *)EC_VREFINT_CAL_ADDR >> EC_VREFINT_CAL_SHIFT;
+    ec_vrefint_sample(true);
+#endif
+
+    // Start the cycle counter used for timing measurements
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+#ifdef EC_FIXED_RATE_SCAN_ENABLE
+    // Start the scan timer, its tick timestamps use the cycle counter
+    gptStart(&GPTD9, &fixed_rate_gpt_config);
+    gptStartContinuous(&GPTD9, EC_SCAN_INTERVAL_US);
+#endif
 
     // Initialize the discharge pin
     gpio_write_pin_low(DISCHARGE_PIN);
@@ -168,6 +710,47 @@ int ec_init(void) {
     return 0;
 }
 
+// Add a reading at rest to the noise statistics of a key (Welford, fixed point)
+EC_SCAN_HOT static void ec_noise_add_sample(runtime_key_state_t *key_runtime, uint16_t sw_value) {
+    // Past the window, halve the weight of the older samples so the statistics follow drift
+    if (key_runtime->noise_count >= EC_NOISE_WINDOW) {
+        key_runtime->noise_count /= 2;
+        key_runtime->noise_m2 /= 2;
+    }
+    key_runtime->noise_count++;
+
+    int32_t delta = ((int32_t)sw_value << 8) - (int32_t)key_runtime->noise_mean;
+    key_runtime->noise_mean += delta / key_runtime->noise_count;
+    int32_t  delta2 = ((int32_t)sw_value << 8) - (int32_t)key_runtime->noise_mean;
+    uint64_t m2     = key_runtime->noise_m2 + (((int64_t)delta * delta2) >> 8);
+    key_runtime->noise_m2 = MIN(m2, UINT32_MAX);
+}
+
+// Standard deviation of the readings at rest
+static float ec_noise_sigma(runtime_key_state_t *key_runtime) {
+    if (key_runtime->noise_count < 2) {
+        return 0.0f;
+    }
+    return sqrtf((float)key_runtime->noise_m2 / (key_runtime->noise_count - 1) / 256.0f);
+}
+
+// Peak to peak noise amplitude derived from the standard deviation
+static ec_offset_t ec_noise_amplitude(runtime_key_state_t *key_runtime) {
+    return MIN(ceilf(EC_NOISE_SIGMA_SPAN * ec_noise_sigma(key_runtime)), EC_OFFSET_MAX);
+}
+
+// Smallest hysteresis that keeps the noise of a key from toggling it
+static inline ec_offset_t ec_min_hysteresis(runtime_key_state_t *key_runtime) {
+    return MIN(key_runtime->noise_amplitude + EC_NOISE_GUARD, EC_OFFSET_MAX);
+}
+
+#ifdef EC_TRAVEL_THRESHOLDS_MM
+// Travel of a key in 0.01 mm for a reading, through the lookup table
+EC_SCAN_HOT static inline uint16_t ec_key_travel(runtime_key_state_t *key_runtime, uint16_t value) {
+    return ec_travel_lookup(value, key_runtime->noise_floor, key_runtime->travel_span, key_runtime->travel_scale);
+}
+#endif
+
 // Initialize the noise floor and rescale per-key thresholds
 void ec_noise_floor_calibration(void) {
     // Column offsets for each AMUX
@@ -178,10 +761,19 @@ void ec_noise_floor_calibration(void) {
         col_offsets[i] = col_offsets[i - 1] + amux_n_col_sizes[i - 1];
     }
 
-    // Initialize all keys' noise floor to expected value
+    // Noise floor accumulators, a 12 bit sum of all samples does not fit the 16 bit noise floor
+    uint32_t noise_floor_sum[MATRIX_ROWS][MATRIX_COLS] = {0};
+
+    // Initialize all keys' noise floor to expected value and restart the noise statistics
     for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
         for (uint8_t col = 0; col < MATRIX_COLS; col++) {
-            runtime_ec_config.runtime_key_state[row][col].noise_floor = EXPECTED_NOISE_FLOOR;
+            runtime_key_state_t *key_runtime = &runtime_ec_config.runtime_key_state[row][col];
+
+            key_runtime->noise_floor     = EXPECTED_NOISE_FLOOR;
+            key_runtime->noise_amplitude = 0;
+            key_runtime->noise_count     = 0;
+            key_runtime->noise_mean      = 0;
+            key_runtime->noise_m2        = 0;
         }
     }
 
@@ -203,7 +795,9 @@ void ec_noise_floor_calibration(void) {
                     // Disable unused rows
                     disable_unused_row(row);
                     // Read the raw switch value and accumulate to noise floor
-                    runtime_ec_config.runtime_key_state[row][adjusted_col].noise_floor += ec_readkey_raw(amux, row, col);
+                    uint16_t value = ec_readkey_raw(amux, row, col);
+                    noise_floor_sum[row][adjusted_col] += value;
+                    ec_noise_add_sample(&runtime_ec_config.runtime_key_state[row][adjusted_col], value);
                 }
             }
         }
@@ -220,18 +814,242 @@ void ec_noise_floor_calibration(void) {
             eeprom_key_state_t  *key_eeprom  = &eeprom_ec_config.eeprom_key_state[row][col];
 
             // Average the noise floor
-            key_runtime->noise_floor /= DEFAULT_NOISE_FLOOR_SAMPLING_COUNT;
+            key_runtime->noise_floor = noise_floor_sum[row][col] / DEFAULT_NOISE_FLOOR_SAMPLING_COUNT;
+            // Noise amplitude from the calibration samples, refined later while the key rests
+            key_runtime->noise_amplitude = ec_noise_amplitude(key_runtime);
             // Rescale all key thresholds based on the new noise floor
             bulk_rescale_key_thresholds(key_runtime, key_eeprom, RESCALE_MODE_ALL);
         }
     }
 }
 
+#ifdef EC_IDLE_SCAN_ENABLE
+// Enter the idle scan mode right away, e.g. on USB suspend
+void ec_idle_scan_enter(void) {
+    if (!idle_scan) {
+        idle_scan = true;
+        idle_scan_stats.entries++;
+        idle_scan_start = ec_cycle_count();
+        idle_prev_start = idle_scan_start;
+    }
+}
+
+// Check if the matrix is scanned at the reduced rate
+bool ec_idle_scan_active(void) {
+    return idle_scan;
+}
+
+// Get the idle scan mode statistics
+const ec_idle_scan_stats_t *ec_idle_scan_get_stats(void) {
+    return &idle_scan_stats;
+}
+
+// Leave the idle scan mode, a reading left the noise band during the current scan
+static void ec_idle_scan_exit(void) {
+    // A change can happen right after the previous scan read the key, so the
+    // time since that scan is the worst case detection delay
+    uint32_t latency = EC_CYCLES_TO_US(ec_cycle_count() - idle_prev_start);
+    if (latency > UINT16_MAX) {
+        latency = UINT16_MAX;
+    }
+    idle_scan_stats.last_wake_latency_us = latency;
+    if (latency > idle_scan_stats.max_wake_latency_us) {
+        idle_scan_stats.max_wake_latency_us = latency;
+    }
+    idle_scan = false;
+    ec_log(EC_LOG_IDLE_SCAN_WAKE, latency, idle_scan_stats.max_wake_latency_us);
+}
+
+// Request or release the idle scan mode from outside the matrix, e.g. on idle manager stage changes.
+// While requested, the reduced rate is entered again as soon as the readings settle after a wake-up.
+void ec_idle_scan_request(bool idle) {
+    idle_scan_requested = idle;
+    if (idle) {
+        ec_idle_scan_enter();
+    } else {
+        idle_scan = false;
+    }
+}
+#endif
+
+#ifdef EC_SCAN_TIMING_ENABLE
+// Number of keys read by a scan
+#    ifdef UNUSED_POSITIONS_LIST
+#        define EC_SCANNED_KEYS (MATRIX_ROWS * MATRIX_COLS - UNUSED_POSITIONS_COUNT)
+#    else
+#        define EC_SCANNED_KEYS (MATRIX_ROWS * MATRIX_COLS)
+#    endif
+
+static ec_scan_timing_stats_t scan_timing_stats = {.key_cycles_min = UINT16_MAX};
+
+// Account the duration of a scan loop
+static void ec_scan_timing_done(uint32_t start) {
+    uint16_t key_cycles = MIN((ec_cycle_count() - start) / EC_SCANNED_KEYS, UINT16_MAX);
+
+    scan_timing_stats.key_cycles_avg = scan_timing_stats.scans ? scan_timing_stats.key_cycles_avg + ((int32_t)key_cycles - scan_timing_stats.key_cycles_avg) / (1 << EC_SCAN_TIMING_FILTER_SHIFT) : key_cycles;
+    scan_timing_stats.key_cycles_min = MIN(scan_timing_stats.key_cycles_min, key_cycles);
+    scan_timing_stats.key_cycles_max = MAX(scan_timing_stats.key_cycles_max, key_cycles);
+    scan_timing_stats.scans++;
+}
+
+// Get the scan loop timing statistics
+const ec_scan_timing_stats_t *ec_scan_timing_get_stats(void) {
+    return &scan_timing_stats;
+}
+#endif
+
+// Handle a fresh switch reading, in bottoming calibration or normal operation
+// Runs while the peak hold capacitor discharges, the next read only waits for what is left of the discharge
+// Returns true if the key state changed
+EC_SCAN_HOT static inline bool ec_process_key(matrix_row_t current_matrix[], uint8_t row, uint8_t col) {
+    // Get pointer to key state in runtime
+    runtime_key_state_t *key_runtime = &runtime_ec_config.runtime_key_state[row][col];
+
+    // In bottoming calibration mode
+    if (runtime_ec_config.bottoming_calibration) {
+        // Only track keys that are actually pressed (above noise floor + threshold)
+        if (sw_value[row][col] > key_runtime->noise_floor + BOTTOMING_CALIBRATION_THRESHOLD) {
+            if (key_runtime->bottoming_calibration_starter) {
+                // First time seeing this key pressed - initialize with actual pressed value
+                key_runtime->bottoming_calibration_reading = sw_value[row][col];
+                key_runtime->bottoming_calibration_starter = false;
+            } else if (sw_value[row][col] > key_runtime->bottoming_calibration_reading) {
+                // Update bottoming reading if current reading is higher
+                key_runtime->bottoming_calibration_reading = sw_value[row][col];
+            }
+        }
+        return false;
+    }
+
+    // Normal operation mode
+#if defined(EC_MIDI_ENABLE) || defined(EC_ANALOG_MOUSE_ENABLE)
+    bool claimed = false;
+#    ifdef EC_MIDI_ENABLE
+    // Keys played as MIDI notes
+    if (ec_midi_claimed(row, col)) {
+        ec_update_key_velocity(key_runtime, sw_value[row][col]);
+        ec_midi_update_key(row, col, ec_get_key_depth(row, col), key_runtime->velocity);
+        claimed = true;
+    }
+#    endif
+#    ifdef EC_ANALOG_MOUSE_ENABLE
+    // Keys moving the pointer, read back by the analog mouse tick
+    claimed |= ec_analog_mouse_claimed(row, col);
+#    endif
+    // Claimed keys never reach the keyboard matrix, release them if they were pressed when claimed
+    if (claimed) {
+        if (current_matrix[row] & (1 << col)) {
+            current_matrix[row] &= ~(1 << col);
+            return true;
+        }
+        return false;
+    }
+#endif
+    // Update the key state and track if any change occurred
+    return ec_update_key(&current_matrix[row], row, col, sw_value[row][col]);
+}
+
+#ifdef EC_WS2812_SCHEDULED
+// Known wait in cycles before the next scan starts, 0 if it may start right away
+static uint32_t ec_scan_gap_cycles(void) {
+#    ifdef EC_IDLE_SCAN_ENABLE
+    if (idle_scan) {
+        uint32_t elapsed = ec_cycle_count() - idle_scan_start;
+        uint32_t period  = EC_US_TO_CYCLES(EC_IDLE_SCAN_INTERVAL * 1000UL);
+        return elapsed < period ? period - elapsed : 0;
+    }
+#    endif
+#    ifdef EC_FIXED_RATE_SCAN_ENABLE
+    // The next scan starts on the next scan timer tick, right away if it already fired
+    if (!fixed_rate_tick) {
+        uint32_t elapsed = ec_cycle_count() - fixed_rate_tick_time;
+        uint32_t period  = EC_US_TO_CYCLES(EC_SCAN_INTERVAL_US);
+        return elapsed < period ? period - elapsed : 0;
+    }
+#    endif
+    return 0;
+}
+#endif
+
 // Scan the EC switch matrix
-bool ec_matrix_scan(matrix_row_t current_matrix[]) {
+EC_SCAN_HOT bool ec_matrix_scan(matrix_row_t current_matrix[]) {
     // Variable to track if any key state has changed
     bool updated = false;
 
+#ifdef EC_IDLE_SCAN_ENABLE
+    // Variable to track if any reading left the noise band
+    bool active = runtime_ec_config.bottoming_calibration;
+#    ifdef EC_ANALOG_STREAM_ENABLE
+    // Keep the full rate while the host is streaming
+    active |= ec_analog_stream_active();
+#    endif
+
+    if (idle_scan) {
+        // Sleep until the next idle scan, the core sits in WFI meanwhile
+        uint32_t elapsed = EC_CYCLES_TO_US(ec_cycle_count() - idle_scan_start) / 1000;
+        if (elapsed < EC_IDLE_SCAN_INTERVAL) {
+            wait_ms(EC_IDLE_SCAN_INTERVAL - elapsed);
+        }
+        idle_prev_start = idle_scan_start;
+        idle_scan_start = ec_cycle_count();
+    }
+#endif
+
+#ifdef EC_SOF_SYNC_ENABLE
+    // Phase-lock the scan to the USB frames
+#    ifdef EC_IDLE_SCAN_ENABLE
+    // The idle scan mode keeps its own pace
+    if (!idle_scan) {
+        ec_sof_align();
+    }
+#    else
+    ec_sof_align();
+#    endif
+#endif
+
+#ifdef EC_FIXED_RATE_SCAN_ENABLE
+    // Start the scan on the next scan timer tick so every key is sampled at a fixed interval
+#    ifdef EC_IDLE_SCAN_ENABLE
+    // The idle scan mode keeps its own pace
+    if (idle_scan) {
+        ec_fixed_rate_pause();
+    } else {
+        ec_fixed_rate_wait();
+    }
+#    else
+    ec_fixed_rate_wait();
+#    endif
+#endif
+
+#ifdef EC_TEMP_COMPENSATION_ENABLE
+    // Follow the temperature drift at a low rate, outside of the bottoming calibration
+    if (!runtime_ec_config.bottoming_calibration && (!temp_started || timer_elapsed(temp_time) >= EC_TEMP_INTERVAL)) {
+        ec_temp_task(current_matrix);
+        temp_time = timer_read();
+    }
+#endif
+
+#ifdef EC_VREFINT_ENABLE
+    // Follow the supply voltage, the correction applies to the whole scan
+    if (timer_elapsed(vrefint_time) >= EC_VREFINT_INTERVAL) {
+        ec_vrefint_sample(false);
+        vrefint_time = timer_read();
+    }
+#endif
+
+#ifdef EC_SCAN_TIMING_ENABLE
+    // Start of the scan loop, after the pacing waits
+    uint32_t timing_start = ec_cycle_count();
+#endif
+
+#ifdef EC_TWO_TIER_SCAN_ENABLE
+    // Skip the triage from time to time, resting keys are only seen at full precision then
+    bool fine_scan = runtime_ec_config.bottoming_calibration || ++coarse_scan_count >= EC_COARSE_REFRESH_SCANS;
+    if (fine_scan) {
+        coarse_scan_count = 0;
+    }
+#endif
+
     // Column offsets for each AMUX
     uint8_t col_offsets[AMUX_COUNT];
     col_offsets[0] = 0;
@@ -240,6 +1058,78 @@ bool ec_matrix_scan(matrix_row_t current_matrix[]) {
         col_offsets[i] = col_offsets[i - 1] + amux_n_col_sizes[i - 1];
     }
 
+#ifdef EC_WS2812_SCHEDULED
+    // Keys skipped while the LED line switched, read again at the end of the scan
+    matrix_row_t ws2812_skipped[MATRIX_ROWS] = {0};
+    bool         ws2812_skipped_any          = false;
+#endif
+
+#ifdef ANALOG_PORTS
+    // Iterate through all AMUX channels, the columns on the same channel of every AMUX are read at once
+    for (uint8_t ch = 0; ch < AMUX_CHANNEL_COUNT; ch++) {
+        // Skip channels no AMUX uses
+        if (!select_amux_channel_all(ch)) continue;
+        for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+#    ifdef EC_WS2812_SCHEDULED
+            // Skip the keys while the LED line switches, they are read again at the end of the scan
+            if (ec_ws2812_tag_reading()) {
+                for (uint8_t amux = 0; amux < AMUX_COUNT; amux++) {
+                    uint8_t col = amux_channel_cols[amux][ch];
+                    if (col == AMUX_NO_COL) continue;
+                    ws2812_skipped[row] |= (matrix_row_t)1 << (col + col_offsets[amux]);
+                }
+                ws2812_skipped_any = true;
+                continue;
+            }
+#    endif
+            // Disable unused rows
+            disable_unused_row(row);
+            // Readings of this row on every AMUX
+            uint16_t values[AMUX_COUNT];
+#    ifdef EC_TWO_TIER_SCAN_ENABLE
+            // Triage the keys with a coarse read, read them again at full precision if any is close to a decision
+            bool fine = fine_scan;
+            if (!fine) {
+                ec_readkeys(row, values, true);
+                for (uint8_t amux = 0; amux < AMUX_COUNT && !fine; amux++) {
+                    uint8_t col = amux_channel_cols[amux][ch];
+                    if (col == AMUX_NO_COL) continue;
+                    fine = ec_key_needs_fine_read(&runtime_ec_config.runtime_key_state[row][col + col_offsets[amux]], values[amux]);
+                }
+            }
+            if (fine) {
+                ec_readkeys(row, values, false);
+            }
+            coarse_reading = !fine;
+#    else
+            // Read the raw switch values
+            ec_readkeys(row, values, false);
+#    endif
+            for (uint8_t amux = 0; amux < AMUX_COUNT; amux++) {
+                // Column of this AMUX on the channel, if any
+                uint8_t col = amux_channel_cols[amux][ch];
+                if (col == AMUX_NO_COL) continue;
+                // Adjusted column index in the full matrix
+                uint8_t adjusted_col = col + col_offsets[amux];
+                // Skip unused positions if specified
+#    ifdef UNUSED_POSITIONS_LIST
+                if (is_unused_position(row, adjusted_col)) continue;
+#    endif
+                sw_value[row][adjusted_col] = values[amux];
+
+#    ifdef EC_IDLE_SCAN_ENABLE
+                // Any reading outside the noise band keeps the full scan rate
+                if (sw_value[row][adjusted_col] > runtime_ec_config.runtime_key_state[row][adjusted_col].noise_floor + EC_IDLE_NOISE_BAND) {
+                    active = true;
+                }
+#    endif
+
+                // Handle bottoming calibration or update key state
+                updated |= ec_process_key(current_matrix, row, adjusted_col);
+            }
+        }
+    }
+#else
     // Iterate through all AMUXs and columns
     for (uint8_t amux = 0; amux < AMUX_COUNT; amux++) {
         // Disable unused AMUXs
@@ -249,46 +1139,140 @@ bool ec_matrix_scan(matrix_row_t current_matrix[]) {
             uint8_t adjusted_col = col + col_offsets[amux];
             for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
                 // Skip unused positions if specified
-#ifdef UNUSED_POSITIONS_LIST
+#    ifdef UNUSED_POSITIONS_LIST
                 if (is_unused_position(row, adjusted_col)) continue;
-#endif
+#    endif
+#    ifdef EC_WS2812_SCHEDULED
+                // Skip the key while the LED line switches, it is read again at the end of the scan
+                if (ec_ws2812_tag_reading()) {
+                    ws2812_skipped[row] |= (matrix_row_t)1 << adjusted_col;
+                    ws2812_skipped_any = true;
+                    continue;
+                }
+#    endif
                 // Disable unused rows
                 disable_unused_row(row);
+#    ifdef EC_TWO_TIER_SCAN_ENABLE
+                // Triage the key with a coarse read, read it again at full precision only close to a decision
+                bool fine = fine_scan;
+                if (!fine) {
+                    sw_value[row][adjusted_col] = ec_readkey(amux, row, col, true);
+                    fine                        = ec_key_needs_fine_read(&runtime_ec_config.runtime_key_state[row][adjusted_col], sw_value[row][adjusted_col]);
+                }
+                if (fine) {
+                    sw_value[row][adjusted_col] = ec_readkey_raw(amux, row, col);
+                }
+                coarse_reading = !fine;
+#    else
                 // Read the raw switch value
                 sw_value[row][adjusted_col] = ec_readkey_raw(amux, row, col);
-                // Get pointer to key state in runtime
-                runtime_key_state_t *key_runtime = &runtime_ec_config.runtime_key_state[row][adjusted_col];
+#    endif
+
+#    ifdef EC_IDLE_SCAN_ENABLE
+                // Any reading outside the noise band keeps the full scan rate
+                if (sw_value[row][adjusted_col] > runtime_ec_config.runtime_key_state[row][adjusted_col].noise_floor + EC_IDLE_NOISE_BAND) {
+                    active = true;
+                }
+#    endif
 
                 // Handle bottoming calibration or update key state
-                // In bottoming calibration mode
-                if (runtime_ec_config.bottoming_calibration) {
-                    // Only track keys that are actually pressed (above noise floor + threshold)
-                    if (sw_value[row][adjusted_col] > key_runtime->noise_floor + BOTTOMING_CALIBRATION_THRESHOLD) {
-                        if (key_runtime->bottoming_calibration_starter) {
-                            // First time seeing this key pressed - initialize with actual pressed value
-                            key_runtime->bottoming_calibration_reading = sw_value[row][adjusted_col];
-                            key_runtime->bottoming_calibration_starter = false;
-                        } else if (sw_value[row][adjusted_col] > key_runtime->bottoming_calibration_reading) {
-                            // Update bottoming reading if current reading is higher
-                            key_runtime->bottoming_calibration_reading = sw_value[row][adjusted_col];
-                        }
+                updated |= ec_process_key(current_matrix, row, adjusted_col);
+            }
+        }
+    }
+#endif
+
+#ifdef EC_WS2812_SCHEDULED
+    // Read the skipped keys at full precision once the LED line is quiet, before the scan ends
+    if (ws2812_skipped_any) {
+        ec_ws2812_wait();
+        for (uint8_t amux = 0; amux < AMUX_COUNT; amux++) {
+            // Disable unused AMUXs
+            disable_unused_amux(amux);
+            for (uint8_t col = 0; col < amux_n_col_sizes[amux]; col++) {
+                // Adjusted column index in the full matrix
+                uint8_t adjusted_col = col + col_offsets[amux];
+                for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+                    if (!(ws2812_skipped[row] & ((matrix_row_t)1 << adjusted_col))) continue;
+#    ifdef UNUSED_POSITIONS_LIST
+                    if (is_unused_position(row, adjusted_col)) continue;
+#    endif
+                    // Disable unused rows
+                    disable_unused_row(row);
+                    sw_value[row][adjusted_col] = ec_readkey_raw(amux, row, col);
+#    ifdef EC_TWO_TIER_SCAN_ENABLE
+                    coarse_reading = false;
+#    endif
+
+#    ifdef EC_IDLE_SCAN_ENABLE
+                    // Any reading outside the noise band keeps the full scan rate
+                    if (sw_value[row][adjusted_col] > runtime_ec_config.runtime_key_state[row][adjusted_col].noise_floor + EC_IDLE_NOISE_BAND) {
+                        active = true;
                     }
-                } else { // Normal operation mode
-                    // Update the key state and track if any change occurred
-                    updated |= ec_update_key(&current_matrix[row], row, adjusted_col, sw_value[row][adjusted_col]);
+#    endif
+
+                    // Handle bottoming calibration or update key state
+                    updated |= ec_process_key(current_matrix, row, adjusted_col);
                 }
             }
         }
     }
+#endif
+
+#ifdef EC_SCAN_TIMING_ENABLE
+    ec_scan_timing_done(timing_start);
+#endif
+
+#ifdef EC_SOF_SYNC_ENABLE
+    // Measure the scan against its target start of frame
+    ec_sof_scan_done();
+#endif
+
+#ifdef EC_ANALOG_MOUSE_ENABLE
+    // Move the pointer from the fresh readings
+    if (!runtime_ec_config.bottoming_calibration) {
+        ec_analog_mouse_task();
+    }
+#endif
+
+#ifdef EC_ANALOG_STREAM_ENABLE
+    // Hand the fresh readings over to the analog stream
+    ec_analog_stream_snapshot(sw_value);
+#endif
+
+#ifdef EC_IDLE_SCAN_ENABLE
+    // Pressed keys keep the full scan rate as well
+    for (uint8_t row = 0; row < MATRIX_ROWS && !active; row++) {
+        active = current_matrix[row] != 0;
+    }
+
+    if (active) {
+        // Back to full rate, this scan already processed the new readings
+        if (idle_scan) {
+            ec_idle_scan_exit();
+        }
+        idle_quiet_timer = timer_read32();
+    } else if (!idle_scan && (idle_scan_requested || (EC_IDLE_SCAN_TIMEOUT && timer_elapsed32(idle_quiet_timer) >= EC_IDLE_SCAN_TIMEOUT))) {
+        ec_idle_scan_enter();
+    }
+#endif
+
+#ifdef EC_WS2812_SCHEDULED
+    // Send the pending LED frame once every key of this scan is read, preferably into the wait before the next scan
+    ec_ws2812_task(ec_scan_gap_cycles());
+#endif
 
     return runtime_ec_config.bottoming_calibration ? false : updated;
 }
 
-// Read the raw switch value from specified channel, row, and column
-uint16_t ec_readkey_raw(uint8_t channel, uint8_t row, uint8_t col) {
+// Read the switch value from specified channel, row, and column, at full precision or with the coarse conversion
+EC_SCAN_HOT static inline uint16_t ec_readkey(uint8_t channel, uint8_t row, uint8_t col, bool coarse) {
     // Variable to store the switch value
     uint16_t sw_value = 0;
 
+    // Let the previous read finish discharging, its key was processed meanwhile
+    ec_discharge_wait();
+
     // Select the AMUX channel and column
     select_amux_channel(channel, col);
 
@@ -302,18 +1286,172 @@ uint16_t ec_readkey_raw(uint8_t channel, uint8_t row, uint8_t col) {
         // Waiting for the capacitor to charge
         wait_us(CHARGE_TIME);
         // Read the ADC value
-        sw_value = adc_read(adcMux);
+#ifdef EC_TWO_TIER_SCAN_ENABLE
+        sw_value = coarse ? ec_adc_read_coarse() : adc_read(EC_ADC_MUX(channel));
+#else
+        sw_value = adc_read(EC_ADC_MUX(channel));
+#endif
     }
-    // Discharge peak hold capacitor
+    // Discharge peak hold capacitor, the caller processes the reading while it discharges
     discharge_capacitor();
-    // Waiting for the ghost capacitor to discharge fully
-    wait_us(DISCHARGE_TIME);
+
+#ifdef EC_VREFINT_ENABLE
+    // Cancel the supply voltage droop so the thresholds keep their meaning under LED load
+    sw_value = ec_vdda_normalize(sw_value);
+#endif
 
     return sw_value;
 }
 
+// Read the raw switch value from specified channel, row, and column
+EC_SCAN_HOT uint16_t ec_readkey_raw(uint8_t channel, uint8_t row, uint8_t col) {
+    return ec_readkey(channel, row, col, false);
+}
+
+#ifdef ANALOG_PORTS
+// Read the switch values of a row on every AMUX at once, the channels must be selected beforehand
+EC_SCAN_HOT static inline void ec_readkeys(uint8_t row, uint16_t values[], bool coarse) {
+    // Samples of every analog input
+    adcsample_t samples[AMUX_COUNT];
+
+    // Let the previous read finish discharging, its keys were processed meanwhile
+    ec_discharge_wait();
+
+    // Ensure the row pin is low before starting
+    gpio_write_pin_low(row_pins[row]);
+
+    // Atomic block to prevent interruptions during the critical timing section
+    ATOMIC_BLOCK_FORCEON {
+        // Charge the peak hold capacitors
+        charge_capacitor(row);
+        // Waiting for the capacitors to charge
+        wait_us(CHARGE_TIME);
+        // Convert all the analog inputs in one regular sequence, the switch readings all come from ADC1
+#    ifdef EC_TWO_TIER_SCAN_ENABLE
+        adcConvert(&ADCD1, coarse ? &coarseGroup : &scanGroup, samples, 1);
+#    else
+        adcConvert(&ADCD1, &scanGroup, samples, 1);
+#    endif
+    }
+    // Discharge peak hold capacitors, the caller processes the readings while they discharge
+    discharge_capacitor();
+
+    for (uint8_t amux = 0; amux < AMUX_COUNT; amux++) {
+#    ifdef EC_TWO_TIER_SCAN_ENABLE
+        values[amux] = coarse ? EC_COARSE_TO_READING(samples[amux]) : samples[amux];
+#    else
+        values[amux] = samples[amux];
+#    endif
+#    ifdef EC_VREFINT_ENABLE
+        // Cancel the supply voltage droop so the thresholds keep their meaning under LED load
+        values[amux] = ec_vdda_normalize(values[amux]);
+#    endif
+    }
+}
+#endif
+
+// Update the filtered velocity of a key from its new reading
+EC_SCAN_HOT static inline void ec_update_key_velocity(runtime_key_state_t *key_runtime, uint16_t sw_value) {
+    uint32_t now     = ec_cycle_count();
+    uint32_t elapsed = EC_CYCLES_TO_US(now - key_runtime->last_sample);
+
+    if (elapsed > 0) {
+        // Instant velocity in 1/256 10 bit counts per ms
+        int32_t instant = ((int32_t)sw_value - key_runtime->last_value) * (256 >> EC_ADC_EXTRA_BITS) * 1000 / (int32_t)MIN(elapsed, INT16_MAX);
+        instant         = MAX(MIN(instant, INT16_MAX), -INT16_MAX);
+        // Exponential moving average
+        key_runtime->velocity += (instant - key_runtime->velocity) / (1 << EC_VELOCITY_FILTER_SHIFT);
+    }
+    key_runtime->sample_period_us = MIN(elapsed, UINT16_MAX);
+    key_runtime->last_value       = sw_value;
+    key_runtime->last_sample      = now;
+}
+
+#ifdef EC_ONLINE_CALIBRATION_ENABLE
+static bool     online_cal_dirty     = false; // Tracked readings not saved to EEPROM yet
+static uint32_t online_cal_save_time = 0;     // Time of the last EEPROM write
+
+// Fold the peak of a finished stroke into the bottom-out estimate of a key
+static void ec_online_calibration_stroke(runtime_key_state_t *key_runtime, eeprom_key_state_t *key_eeprom, uint16_t peak) {
+    key_runtime->stroke_count++;
+
+    uint16_t bottom = key_runtime->online_bottom;
+    if (bottom == 0) {
+        if (key_eeprom->bottoming_calibration_reading != DEFAULT_BOTTOMING_CALIBRATION_READING) {
+            // First stroke: start from the stored reading
+            bottom = key_eeprom->bottoming_calibration_reading;
+        } else {
+            // Never calibrated: wait for several deep strokes, a single partial press would leave a hair trigger span
+            if (peak < key_runtime->noise_floor + EC_ONLINE_CAL_MIN_SPAN) {
+                return;
+            }
+            key_runtime->adopt_peak = MAX(key_runtime->adopt_peak, peak);
+            if (++key_runtime->adopt_strokes < EC_ONLINE_CAL_ADOPT_STROKES) {
+                return;
+            }
+            bottom = key_runtime->adopt_peak;
+        }
+        key_runtime->reference_bottom = bottom;
+    } else if (peak > bottom) {
+        // Deeper than the estimate: rise by a bounded step to reject outliers
+        bottom += MIN(peak - bottom, EC_ONLINE_CAL_RISE);
+    } else if (peak + ((bottom - key_runtime->noise_floor) >> EC_ONLINE_CAL_BAND_SHIFT) >= bottom) {
+        // Bottomed out short of the estimate: decay slowly, partial strokes are ignored
+        bottom -= (bottom - peak) >> EC_ONLINE_CAL_DECAY_SHIFT;
+    }
+    key_runtime->online_bottom = bottom;
+
+    // Rescale only this key, and only once the estimate moved enough
+    uint16_t applied = key_runtime->bottoming_calibration_reading;
+    if ((bottom > applied ? bottom - applied : applied - bottom) >= EC_ONLINE_CAL_MIN_CHANGE) {
+        key_runtime->bottoming_calibration_reading = bottom;
+        key_eeprom->bottoming_calibration_reading  = bottom;
+        bulk_rescale_key_thresholds(key_runtime, key_eeprom, RESCALE_MODE_ALL);
+        online_cal_dirty = true;
+    }
+}
+
+// Track the strokes of a key, a stroke ends when the key comes back near its noise floor
+static inline void ec_online_calibration_track(runtime_key_state_t *key_runtime, eeprom_key_state_t *key_eeprom, uint16_t sw_value) {
+    if (sw_value > key_runtime->noise_floor + BOTTOMING_CALIBRATION_THRESHOLD) {
+        key_runtime->stroke_peak = MAX(key_runtime->stroke_peak, sw_value);
+    } else if (key_runtime->stroke_peak && sw_value < key_runtime->noise_floor + BOTTOMING_CALIBRATION_THRESHOLD / 2) {
+        ec_online_calibration_stroke(key_runtime, key_eeprom, key_runtime->stroke_peak);
+        key_runtime->stroke_peak = 0;
+    }
+}
+
+// Save the tracked readings, rate limited to spare the EEPROM
+void ec_online_calibration_task(void) {
+    if (online_cal_dirty && timer_elapsed32(online_cal_save_time) >= EC_ONLINE_CAL_SAVE_INTERVAL) {
+        eeconfig_update_kb_datablock_field(eeprom_ec_config, eeprom_key_state);
+        online_cal_dirty     = false;
+        online_cal_save_time = timer_read32();
+    }
+}
+
+// Restart the tracking from the stored readings, after a manual calibration or a clear
+void ec_online_calibration_reset(void) {
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            runtime_ec_config.runtime_key_state[row][col].stroke_peak   = 0;
+            runtime_ec_config.runtime_key_state[row][col].online_bottom = 0;
+            runtime_ec_config.runtime_key_state[row][col].adopt_peak    = 0;
+            runtime_ec_config.runtime_key_state[row][col].adopt_strokes = 0;
+        }
+    }
+    online_cal_dirty = false;
+}
+
+// Get the change of the bottom-out reading of a key since the tracking started, a sign of switch wear
+int16_t ec_get_key_bottom_drift(uint8_t row, uint8_t col) {
+    runtime_key_state_t *key_runtime = &runtime_ec_config.runtime_key_state[row][col];
+    return key_runtime->online_bottom ? (int16_t)(key_runtime->online_bottom - key_runtime->reference_bottom) : 0;
+}
+#endif
+
 // Update the key state based on the switch value
-bool ec_update_key(matrix_row_t *current_row, uint8_t row, uint8_t col, uint16_t sw_value) {
+EC_SCAN_HOT bool ec_update_key(matrix_row_t *current_row, uint8_t row, uint8_t col, uint16_t sw_value) {
     // Get pointer to key state in runtime and EEPROM
     runtime_key_state_t *key_runtime = &runtime_ec_config.runtime_key_state[row][col];
     eeprom_key_state_t  *key_eeprom  = &eeprom_ec_config.eeprom_key_state[row][col];
@@ -321,26 +1459,61 @@ bool ec_update_key(matrix_row_t *current_row, uint8_t row, uint8_t col, uint16_t
     // Current pressed state
     bool pressed = (*current_row >> col) & 1;
 
+#ifdef EC_TWO_TIER_SCAN_ENABLE
+    // Coarse readings only take key state decisions, the statistics and estimates are fed by full precision ones
+    bool fine_reading = !coarse_reading;
+#else
+    bool fine_reading = true;
+#endif
+
     // Update noise floor if current reading is lower than existing noise floor minus threshold
-    if (sw_value + NOISE_FLOOR_THRESHOLD < key_runtime->noise_floor) {
+    if (fine_reading && sw_value + NOISE_FLOOR_THRESHOLD < key_runtime->noise_floor) {
+#ifdef EC_TEMP_COMPENSATION_ENABLE
+        // Move the reference level along, the fitted drift applies on top of it
+        key_runtime->temp_base_floor = MAX(key_runtime->temp_base_floor - (key_runtime->noise_floor - sw_value), 0);
+#endif
         // Update noise floor
         key_runtime->noise_floor = sw_value;
         // Rescale all key thresholds based on new noise floor
         bulk_rescale_key_thresholds(key_runtime, key_eeprom, RESCALE_MODE_ALL);
     }
 
+    // Keep characterizing the noise while the key rests, refresh the minimum hysteresis when it changes
+    if (fine_reading && !pressed && sw_value < key_runtime->noise_floor + NOISE_FLOOR_THRESHOLD) {
+        ec_noise_add_sample(key_runtime, sw_value);
+        if (key_runtime->noise_count % EC_NOISE_REFRESH == 0) {
+            ec_offset_t amplitude = ec_noise_amplitude(key_runtime);
+            if (amplitude != key_runtime->noise_amplitude) {
+                key_runtime->noise_amplitude = amplitude;
+                bulk_rescale_key_thresholds(key_runtime, key_eeprom, RESCALE_MODE_ALL);
+            }
+        }
+    }
+
+    if (fine_reading) {
+#ifdef EC_ONLINE_CALIBRATION_ENABLE
+        // Refine the bottom-out reading from the strokes of normal use
+        ec_online_calibration_track(key_runtime, key_eeprom, sw_value);
+#endif
+
+        // Update the velocity estimate
+        ec_update_key_velocity(key_runtime, sw_value);
+    }
+
     // Update key state based on actuation mode
     if (key_runtime->actuation_mode == 0) {
         return ec_update_key_apc(current_row, col, sw_value, key_runtime, pressed);
     } else if (key_runtime->actuation_mode == 1) {
         return ec_update_key_rt(current_row, col, sw_value, key_runtime, pressed);
+    } else if (key_runtime->actuation_mode == 2) {
+        return ec_update_key_vrt(current_row, col, sw_value, key_runtime, pressed);
     }
 
     return false;
 }
 
 // Update the key state in APC mode
-bool ec_update_key_apc(matrix_row_t *current_row, uint8_t col, uint16_t sw_value, runtime_key_state_t *key_runtime, bool pressed) {
+EC_SCAN_HOT bool ec_update_key_apc(matrix_row_t *current_row, uint8_t col, uint16_t sw_value, runtime_key_state_t *key_runtime, bool pressed) {
     // Check for release condition
     if (pressed && sw_value < key_runtime->rescaled_apc_release_threshold) {
         // Key released
@@ -357,36 +1530,47 @@ bool ec_update_key_apc(matrix_row_t *current_row, uint8_t col, uint16_t sw_value
 }
 
 // Update the key state in RT mode
-bool ec_update_key_rt(matrix_row_t *current_row, uint8_t col, uint16_t sw_value, runtime_key_state_t *key_runtime, bool pressed) {
+EC_SCAN_HOT bool ec_update_key_rt(matrix_row_t *current_row, uint8_t col, uint16_t sw_value, runtime_key_state_t *key_runtime, bool pressed) {
+#ifdef EC_TRAVEL_THRESHOLDS_MM
+    // Compare travel, the offsets keep their length over the whole stroke
+    uint16_t    position         = ec_key_travel(key_runtime, sw_value);
+    ec_offset_t actuation_offset = key_runtime->travel_rt_actuation_offset;
+    ec_offset_t release_offset   = key_runtime->travel_rt_release_offset;
+#else
+    uint16_t    position         = sw_value;
+    ec_offset_t actuation_offset = key_runtime->rescaled_rt_actuation_offset;
+    ec_offset_t release_offset   = key_runtime->rescaled_rt_release_offset;
+#endif
+
     // Key in active zone
     if (sw_value > key_runtime->rescaled_rt_initial_deadzone_offset) {
         if (pressed) {
             // Track downward movement
-            if (sw_value > key_runtime->extremum) {
-                key_runtime->extremum = sw_value;
+            if (position > key_runtime->extremum) {
+                key_runtime->extremum = position;
             }
             // Check for release threshold
-            else if (sw_value < key_runtime->extremum - key_runtime->rescaled_rt_release_offset) {
-                key_runtime->extremum = sw_value;
+            else if (position < key_runtime->extremum - release_offset) {
+                key_runtime->extremum = position;
                 *current_row &= ~(1 << col);
                 return true;
             }
         } else {
             // Track upward movement
-            if (sw_value < key_runtime->extremum) {
-                key_runtime->extremum = sw_value;
+            if (position < key_runtime->extremum) {
+                key_runtime->extremum = position;
             }
             // Check for actuation threshold
-            else if (sw_value > key_runtime->extremum + key_runtime->rescaled_rt_actuation_offset) {
-                key_runtime->extremum = sw_value;
+            else if (position > key_runtime->extremum + actuation_offset) {
+                key_runtime->extremum = position;
                 *current_row |= (1 << col);
                 return true;
             }
         }
     }
     // Key outside active zone - force release if extremum dropped
-    else if (sw_value < key_runtime->extremum) {
-        key_runtime->extremum = sw_value;
+    else if (position < key_runtime->extremum) {
+        key_runtime->extremum = position;
         *current_row &= ~(1 << col);
         return true;
     }
@@ -394,30 +1578,165 @@ bool ec_update_key_rt(matrix_row_t *current_row, uint8_t col, uint16_t sw_value,
     return false;
 }
 
+// Scale a Rapid Trigger offset down as the key moves faster
+static inline ec_offset_t ec_velocity_scale_offset(ec_offset_t offset, int16_t velocity, ec_offset_t min_offset) {
+    // Speed in counts per ms
+    uint16_t speed = (velocity < 0 ? -velocity : velocity) >> 8;
+    uint16_t scale = EC_VELOCITY_RT_MIN_SCALE;
+    if (speed < EC_VELOCITY_RT_FULL_SPEED) {
+        scale = 256 - (256 - EC_VELOCITY_RT_MIN_SCALE) * speed / EC_VELOCITY_RT_FULL_SPEED;
+    }
+    // Never go below the offset the key noise allows
+    ec_offset_t scaled = ((uint32_t)offset * scale) >> 8;
+    return MAX(scaled, min_offset);
+}
+
+// Update the key state in Velocity RT mode: RT with offsets shrinking as the key moves faster
+EC_SCAN_HOT bool ec_update_key_vrt(matrix_row_t *current_row, uint8_t col, uint16_t sw_value, runtime_key_state_t *key_runtime, bool pressed) {
+#ifdef EC_TRAVEL_THRESHOLDS_MM
+    // Compare travel, the offsets keep their length over the whole stroke
+    uint16_t    position         = ec_key_travel(key_runtime, sw_value);
+    ec_offset_t min_offset       = key_runtime->travel_min_offset;
+    ec_offset_t actuation_offset = ec_velocity_scale_offset(key_runtime->travel_rt_actuation_offset, key_runtime->velocity, min_offset);
+    ec_offset_t release_offset   = ec_velocity_scale_offset(key_runtime->travel_rt_release_offset, key_runtime->velocity, min_offset);
+#else
+    uint16_t    position         = sw_value;
+    ec_offset_t min_offset       = ec_min_hysteresis(key_runtime);
+    ec_offset_t actuation_offset = ec_velocity_scale_offset(key_runtime->rescaled_rt_actuation_offset, key_runtime->velocity, min_offset);
+    ec_offset_t release_offset   = ec_velocity_scale_offset(key_runtime->rescaled_rt_release_offset, key_runtime->velocity, min_offset);
+#endif
+#ifdef EC_VELOCITY_RT_PREDICT
+    // Value expected at the next sample if the key keeps its velocity
+    int32_t predicted = sw_value + (int32_t)key_runtime->velocity * key_runtime->sample_period_us / ((256 * 1000) >> EC_ADC_EXTRA_BITS);
+#    ifdef EC_TRAVEL_THRESHOLDS_MM
+    predicted = ec_key_travel(key_runtime, MAX(MIN(predicted, EC_ADC_MAX), 0));
+#    endif
+#else
+    int32_t predicted = position;
+#endif
+
+    // Key in active zone
+    if (sw_value > key_runtime->rescaled_rt_initial_deadzone_offset) {
+        if (pressed) {
+            // Track downward movement
+            if (position > key_runtime->extremum) {
+                key_runtime->extremum = position;
+            }
+            // Check for release threshold, reached now or by the next sample
+            else if (predicted < key_runtime->extremum - release_offset) {
+                key_runtime->extremum = position;
+                *current_row &= ~(1 << col);
+                return true;
+            }
+        } else {
+            // Track upward movement
+            if (position < key_runtime->extremum) {
+                key_runtime->extremum = position;
+            }
+            // Check for actuation threshold, reached now or by the next sample
+            else if (predicted > key_runtime->extremum + actuation_offset) {
+                key_runtime->extremum = position;
+                *current_row |= (1 << col);
+                return true;
+            }
+        }
+    }
+    // Key outside active zone - force release if extremum dropped
+    else if (position < key_runtime->extremum) {
+        key_runtime->extremum = position;
+        *current_row &= ~(1 << col);
+        return true;
+    }
+
+    return false;
+}
+
+#ifdef EC_TRAVEL_THRESHOLDS_MM
+// Convert a threshold in 0.01 mm of travel to a reading of the key
+static inline uint16_t rescale_threshold(uint16_t threshold, runtime_key_state_t *key_runtime, eeprom_key_state_t *key_eeprom) {
+    return ec_travel_to_adc(threshold, key_runtime->noise_floor, key_eeprom->bottoming_calibration_reading);
+}
+
+// Convert an RT offset in 0.01 mm of travel to a reading delta, taken from the RT initial deadzone where RT starts.
+// The delta only serves the noise guard and the statistics, the RT modes compare travel.
+static inline ec_offset_t rescale_offset(ec_offset_t offset, runtime_key_state_t *key_runtime, eeprom_key_state_t *key_eeprom) {
+    uint16_t start = ec_travel_to_adc(key_runtime->rt_initial_deadzone_offset, key_runtime->noise_floor, key_eeprom->bottoming_calibration_reading);
+    uint16_t end   = ec_travel_to_adc(key_runtime->rt_initial_deadzone_offset + offset, key_runtime->noise_floor, key_eeprom->bottoming_calibration_reading);
+    return MAX(MIN(end - start, EC_OFFSET_MAX), 1);
+}
+#else
+// Thresholds and offsets are given in the 0-EC_ADC_MAX reading range
+static inline uint16_t rescale_threshold(uint16_t threshold, runtime_key_state_t *key_runtime, eeprom_key_state_t *key_eeprom) {
+    return rescale(threshold, key_runtime->noise_floor, key_eeprom->bottoming_calibration_reading);
+}
+
+#    ifdef EC_ADC_12BIT
+// Offsets are deltas, scaled by the key span without the noise floor base
+static inline ec_offset_t rescale_offset(ec_offset_t offset, runtime_key_state_t *key_runtime, eeprom_key_state_t *key_eeprom) {
+    uint16_t span = key_eeprom->bottoming_calibration_reading > key_runtime->noise_floor ? key_eeprom->bottoming_calibration_reading - key_runtime->noise_floor : 0;
+    return MAX(MIN((uint32_t)offset * span / EC_ADC_MAX, EC_OFFSET_MAX), 1);
+}
+#    else
+// Offsets keep the original scaling on 10 bit builds, the stored settings keep their effect
+static inline ec_offset_t rescale_offset(ec_offset_t offset, runtime_key_state_t *key_runtime, eeprom_key_state_t *key_eeprom) {
+    return rescale(offset, key_runtime->noise_floor, key_eeprom->bottoming_calibration_reading);
+}
+#    endif
+#endif
+
 // Rescale all key thresholds based on noise floor and bottoming calibration reading
 void bulk_rescale_key_thresholds(runtime_key_state_t *key_runtime, eeprom_key_state_t *key_eeprom, rescale_mode_t mode) {
     // Rescale thresholds based on mode
     switch (mode) {
         case RESCALE_MODE_APC: // APC
-            key_runtime->rescaled_apc_actuation_threshold = rescale(key_runtime->apc_actuation_threshold, key_runtime->noise_floor, key_eeprom->bottoming_calibration_reading);
-            key_runtime->rescaled_apc_release_threshold   = rescale(key_runtime->apc_release_threshold, key_runtime->noise_floor, key_eeprom->bottoming_calibration_reading);
+            key_runtime->rescaled_apc_actuation_threshold = rescale_threshold(key_runtime->apc_actuation_threshold, key_runtime, key_eeprom);
+            key_runtime->rescaled_apc_release_threshold   = rescale_threshold(key_runtime->apc_release_threshold, key_runtime, key_eeprom);
             break;
         case RESCALE_MODE_RT: // RT
-            key_runtime->rescaled_rt_initial_deadzone_offset = rescale(key_runtime->rt_initial_deadzone_offset, key_runtime->noise_floor, key_eeprom->bottoming_calibration_reading);
-            key_runtime->rescaled_rt_actuation_offset        = rescale(key_runtime->rt_actuation_offset, key_runtime->noise_floor, key_eeprom->bottoming_calibration_reading);
-            key_runtime->rescaled_rt_release_offset          = rescale(key_runtime->rt_release_offset, key_runtime->noise_floor, key_eeprom->bottoming_calibration_reading);
+            key_runtime->rescaled_rt_initial_deadzone_offset = rescale_threshold(key_runtime->rt_initial_deadzone_offset, key_runtime, key_eeprom);
+            key_runtime->rescaled_rt_actuation_offset        = rescale_offset(key_runtime->rt_actuation_offset, key_runtime, key_eeprom);
+            key_runtime->rescaled_rt_release_offset          = rescale_offset(key_runtime->rt_release_offset, key_runtime, key_eeprom);
             break;
         case RESCALE_MODE_ALL: // All thresholds
-            key_runtime->rescaled_apc_actuation_threshold    = rescale(key_runtime->apc_actuation_threshold, key_runtime->noise_floor, key_eeprom->bottoming_calibration_reading);
-            key_runtime->rescaled_apc_release_threshold      = rescale(key_runtime->apc_release_threshold, key_runtime->noise_floor, key_eeprom->bottoming_calibration_reading);
-            key_runtime->rescaled_rt_initial_deadzone_offset = rescale(key_runtime->rt_initial_deadzone_offset, key_runtime->noise_floor, key_eeprom->bottoming_calibration_reading);
-            key_runtime->rescaled_rt_actuation_offset        = rescale(key_runtime->rt_actuation_offset, key_runtime->noise_floor, key_eeprom->bottoming_calibration_reading);
-            key_runtime->rescaled_rt_release_offset          = rescale(key_runtime->rt_release_offset, key_runtime->noise_floor, key_eeprom->bottoming_calibration_reading);
+            key_runtime->rescaled_apc_actuation_threshold    = rescale_threshold(key_runtime->apc_actuation_threshold, key_runtime, key_eeprom);
+            key_runtime->rescaled_apc_release_threshold      = rescale_threshold(key_runtime->apc_release_threshold, key_runtime, key_eeprom);
+            key_runtime->rescaled_rt_initial_deadzone_offset = rescale_threshold(key_runtime->rt_initial_deadzone_offset, key_runtime, key_eeprom);
+            key_runtime->rescaled_rt_actuation_offset        = rescale_offset(key_runtime->rt_actuation_offset, key_runtime, key_eeprom);
+            key_runtime->rescaled_rt_release_offset          = rescale_offset(key_runtime->rt_release_offset, key_runtime, key_eeprom);
             break;
         default:
             bulk_rescale_key_thresholds(key_runtime, key_eeprom, RESCALE_MODE_ALL);
-            break;
+            return;
+    }
+
+    // Hysteresis as configured, to tell the keys the guard below raises
+    if (mode != RESCALE_MODE_RT) {
+        uint16_t gap                = key_runtime->rescaled_apc_actuation_threshold > key_runtime->rescaled_apc_release_threshold ? key_runtime->rescaled_apc_actuation_threshold - key_runtime->rescaled_apc_release_threshold : 0;
+        key_runtime->apc_hysteresis = MIN(gap, EC_OFFSET_MAX);
+    }
+    if (mode != RESCALE_MODE_APC) {
+        key_runtime->rt_hysteresis = MIN(key_runtime->rescaled_rt_actuation_offset, key_runtime->rescaled_rt_release_offset);
+    }
+
+    // Keep the hysteresis above the measured noise of the key
+    ec_offset_t min_hysteresis = ec_min_hysteresis(key_runtime);
+    if (key_runtime->rescaled_apc_release_threshold + min_hysteresis > key_runtime->rescaled_apc_actuation_threshold) {
+        key_runtime->rescaled_apc_release_threshold = key_runtime->rescaled_apc_actuation_threshold > min_hysteresis ? key_runtime->rescaled_apc_actuation_threshold - min_hysteresis : 0;
     }
+    key_runtime->rescaled_rt_actuation_offset = MAX(key_runtime->rescaled_rt_actuation_offset, min_hysteresis);
+    key_runtime->rescaled_rt_release_offset   = MAX(key_runtime->rescaled_rt_release_offset, min_hysteresis);
+
+#ifdef EC_TRAVEL_THRESHOLDS_MM
+    // Travel lookup of the RT modes, the noise guard converted at the RT initial deadzone where travel per count is the largest
+    uint16_t bottom                         = key_eeprom->bottoming_calibration_reading;
+    uint16_t deadzone                       = key_runtime->rescaled_rt_initial_deadzone_offset;
+    uint16_t guard                          = ec_adc_to_travel(MIN(deadzone + min_hysteresis, EC_ADC_MAX), key_runtime->noise_floor, bottom) - ec_adc_to_travel(deadzone, key_runtime->noise_floor, bottom);
+    key_runtime->travel_span                = bottom > key_runtime->noise_floor ? bottom - key_runtime->noise_floor : 0;
+    key_runtime->travel_scale               = ec_travel_scale(key_runtime->travel_span);
+    key_runtime->travel_min_offset          = MAX(MIN(guard, EC_OFFSET_MAX), 1);
+    key_runtime->travel_rt_actuation_offset = MAX(key_runtime->rt_actuation_offset, key_runtime->travel_min_offset);
+    key_runtime->travel_rt_release_offset   = MAX(key_runtime->rt_release_offset, key_runtime->travel_min_offset);
+#endif
 }
 
 // Unified helper function to update a field across all keys (runtime-only)
@@ -440,25 +1759,44 @@ void update_keys_field(update_mode_t mode, size_t runtime_offset, size_t eeprom_
     }
 }
 
-// Print the switch matrix values for debugging
+// Print the switch matrix values for debugging (deferred to the log drain)
 void ec_print_matrix(void) {
-    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
-        for (uint8_t col = 0; col < MATRIX_COLS - 1; col++) {
-            uprintf("%4d,", sw_value[row][col]);
-        }
-        uprintf("%4d\n", sw_value[row][MATRIX_COLS - 1]);
+    ec_log(EC_LOG_TABLE, EC_LOG_TABLE_SW_VALUE, 0);
+}
+
+// Get the last raw switch value read for a key
+uint16_t ec_get_sw_value(uint8_t row, uint8_t col) {
+    return sw_value[row][col];
+}
+
+// Get the filtered velocity of a key in 1/256 10 bit counts per ms, positive towards bottom-out
+int16_t ec_get_key_velocity(uint8_t row, uint8_t col) {
+    return runtime_ec_config.runtime_key_state[row][col].velocity;
+}
+
+// Get the travel of a key from its last reading, 0 at rest to 255 at bottom-out
+uint8_t ec_get_key_depth(uint8_t row, uint8_t col) {
+    runtime_key_state_t *key_runtime = &runtime_ec_config.runtime_key_state[row][col];
+    uint16_t             value       = sw_value[row][col];
+    uint16_t             bottom      = key_runtime->bottoming_calibration_reading;
+
+    if (value <= key_runtime->noise_floor || bottom <= key_runtime->noise_floor) {
+        return 0;
+    }
+    if (value >= bottom) {
+        return 255;
     }
-    print("\n");
+    return (uint32_t)(value - key_runtime->noise_floor) * 255 / (bottom - key_runtime->noise_floor);
 }
 
-// rescale a value from 0-1023 to out_min - out_max
+// rescale a value from 0-EC_ADC_MAX to out_min - out_max
 uint16_t rescale(uint16_t x, uint16_t out_min, uint16_t out_max) {
-    return x * (out_max - out_min) / 1023 + out_min;
+    return (uint32_t)x * (out_max - out_min) / EC_ADC_MAX + out_min;
 }
 
 // Check if a position is unused (if UNUSED_POSITIONS_LIST is defined)
 #ifdef UNUSED_POSITIONS_LIST
-bool is_unused_position(uint8_t row, uint8_t col) {
+EC_SCAN_HOT bool is_unused_position(uint8_t row, uint8_t col) {
     // Check against the list of unused positions
     for (uint8_t i = 0; i < UNUSED_POSITIONS_COUNT; i++) {
         // Compare current position with each unused position
@@ -475,3 +1813,51 @@ uint8_t *pIndicators = (uint8_t *)&eeprom_ec_config;
 indicator_config *get_indicator_p(int index) {
     return (indicator_config *)(pIndicators + index * sizeof(indicator_config));
 }
+
+// Get the signal to noise ratio of a key: calibrated travel span over the standard deviation at rest
+uint16_t ec_get_key_snr(uint8_t row, uint8_t col) {
+    runtime_key_state_t *key_runtime = &runtime_ec_config.runtime_key_state[row][col];
+    if (key_runtime->bottoming_calibration_reading <= key_runtime->noise_floor) {
+        return 0;
+    }
+    // Below 1/16 count the noise is below the ADC resolution
+    float sigma = MAX(ec_noise_sigma(key_runtime), 1.0f / 16);
+    return MIN((key_runtime->bottoming_calibration_reading - key_runtime->noise_floor) / sigma, UINT16_MAX);
+}
+
+#ifdef EC_TRAVEL_THRESHOLDS_MM
+// Get the travel of a key in 0.01 mm
+uint16_t ec_get_key_travel(uint8_t row, uint8_t col) {
+    return ec_adc_to_travel(sw_value[row][col], runtime_ec_config.runtime_key_state[row][col].noise_floor, runtime_ec_config.runtime_key_state[row][col].bottoming_calibration_reading);
+}
+#endif
+
+// Get the hysteresis in effect for a key in its actuation mode, after the noise guard
+uint16_t ec_get_key_hysteresis(uint8_t row, uint8_t col) {
+    runtime_key_state_t *key_runtime = &runtime_ec_config.runtime_key_state[row][col];
+
+    if (key_runtime->actuation_mode == 0) {
+        // APC: gap between the actuation and release thresholds
+        return key_runtime->rescaled_apc_actuation_threshold > key_runtime->rescaled_apc_release_threshold ? key_runtime->rescaled_apc_actuation_threshold - key_runtime->rescaled_apc_release_threshold : 0;
+    }
+    // RT: smallest movement that changes the key state
+    return MIN(key_runtime->rescaled_rt_actuation_offset, key_runtime->rescaled_rt_release_offset);
+}
+
+// Hysteresis of a key in its actuation mode as configured, before the noise guard
+static inline ec_offset_t ec_key_configured_hysteresis(runtime_key_state_t *key_runtime) {
+    return key_runtime->actuation_mode == 0 ? key_runtime->apc_hysteresis : key_runtime->rt_hysteresis;
+}
+
+// Check if the noise guard raised the hysteresis of a key above its configured value
+bool ec_key_is_guarded(uint8_t row, uint8_t col) {
+    runtime_key_state_t *key_runtime = &runtime_ec_config.runtime_key_state[row][col];
+    return ec_key_configured_hysteresis(key_runtime) < ec_min_hysteresis(key_runtime);
+}
+
+// Check if the noise of a key at rest reaches the hysteresis configured for its actuation mode,
+// the guard then covers the bare noise but such a key could still chatter and needs a deferred debounce
+bool ec_key_is_noisy(uint8_t row, uint8_t col) {
+    runtime_key_state_t *key_runtime = &runtime_ec_config.runtime_key_state[row][col];
+    return key_runtime->noise_amplitude >= ec_key_configured_hysteresis(key_runtime);
+}
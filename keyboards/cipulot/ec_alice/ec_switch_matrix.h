@@ -21,10 +21,303 @@
 #include <stddef.h>
 #include "matrix.h"
 #include "eeconfig.h"
+#include "action_layer.h"
 #include "util.h"
+#include "hal.h"
 #include "socd_cleaner.h"
 
-// Rescale mode enumeration
+// Cycle counter based timing, the DWT counter is started in ec_init()
+#define EC_CYCLES_PER_US (STM32_SYSCLK / 1000000)
+#define EC_CYCLES_TO_US(cycles) ((cycles) / EC_CYCLES_PER_US)
+#define EC_US_TO_CYCLES(us) ((us) * EC_CYCLES_PER_US)
+
+static inline uint32_t ec_cycle_count(void) {
+    return DWT->CYCCNT;
+}
+
+// Placement of the scan hot path, SRAM with EC_SCAN_FROM_SRAM to keep flash wait states and ART cache misses out of it
+// The ChibiOS linker rules copy .ramtext to SRAM along with the initialized data
+// long_call only applies to the call sites that see it, so it is also on the prototypes: calls from flash load the
+// full address instead of going through a linker veneer. The calls back to flash go through veneers
+#ifdef EC_SCAN_FROM_SRAM
+#    define EC_SCAN_HOT __attribute__((section(".ramtext"), long_call))
+#else
+#    define EC_SCAN_HOT
+#endif
+
+// Switch reading resolution, 12 bits with EC_ADC_12BIT
+#ifdef EC_ADC_12BIT
+#    define EC_ADC_BITS 12
+#else
+#    define EC_ADC_BITS 10
+#endif
+#define EC_ADC_MAX ((1 << EC_ADC_BITS) - 1)
+// ADC resolution bits of the conversion groups driven directly, the same as the switch readings
+#ifdef EC_ADC_12BIT
+#    define EC_ADC_CR1_RESOLUTION ADC_CR1_12B_RESOLUTION
+#else
+#    define EC_ADC_CR1_RESOLUTION ADC_CR1_10B_RESOLUTION
+#endif
+// Bits above the 10 bit resolution the raw count defaults are given in
+#define EC_ADC_EXTRA_BITS (EC_ADC_BITS - 10)
+
+// Rapid Trigger offset storage, 12 bit offsets outgrow a byte
+#ifdef EC_ADC_12BIT
+typedef uint16_t ec_offset_t;
+#    define EC_OFFSET_MAX UINT16_MAX
+#else
+typedef uint8_t ec_offset_t;
+#    define EC_OFFSET_MAX UINT8_MAX
+#endif
+
+// Velocity filter strength, each new sample weighs 1/2^shift
+#ifndef EC_VELOCITY_FILTER_SHIFT
+#    define EC_VELOCITY_FILTER_SHIFT 2
+#endif
+// Velocity in counts per ms at 10 bit resolution at which the Velocity RT offsets reach their minimum
+#ifndef EC_VELOCITY_RT_FULL_SPEED
+#    define EC_VELOCITY_RT_FULL_SPEED 64
+#endif
+// Minimum Velocity RT offset scale, in 1/256
+#ifndef EC_VELOCITY_RT_MIN_SCALE
+#    define EC_VELOCITY_RT_MIN_SCALE 96
+#endif
+
+// Samples at rest after which older samples weigh half in the noise statistics
+#ifndef EC_NOISE_WINDOW
+#    define EC_NOISE_WINDOW 512
+#endif
+// Samples at rest between two refreshes of the noise amplitude
+#ifndef EC_NOISE_REFRESH
+#    define EC_NOISE_REFRESH 64
+#endif
+// Noise amplitude in standard deviations, 6 covers the peak to peak noise with a 3 sigma margin
+#ifndef EC_NOISE_SIGMA_SPAN
+#    define EC_NOISE_SIGMA_SPAN 6
+#endif
+// Margin added to the noise amplitude for the minimum APC hysteresis and RT offsets
+#ifndef EC_NOISE_GUARD
+#    define EC_NOISE_GUARD (2 << EC_ADC_EXTRA_BITS)
+#endif
+
+#ifdef EC_VREFINT_ENABLE
+// Address of the factory VREFINT reading, taken at 3.3 V with 12 bits
+#    ifndef EC_VREFINT_CAL_ADDR
+#        define EC_VREFINT_CAL_ADDR 0x1FFF7A2A
+#    endif
+// Shift from the 12 bit factory reading to the resolution of the switch readings
+#    ifndef EC_VREFINT_CAL_SHIFT
+#        define EC_VREFINT_CAL_SHIFT (12 - EC_ADC_BITS)
+#    endif
+// Supply voltage of the factory reading in mV
+#    ifndef EC_VREFINT_CAL_VDDA
+#        define EC_VREFINT_CAL_VDDA 3300
+#    endif
+// Sampling time of the VREFINT conversions, in ADC clock cycles, at least 10 us on the STM32F411
+#    ifndef EC_VREFINT_SAMPLING_TIME
+#        define EC_VREFINT_SAMPLING_TIME ADC_SAMPLE_480
+#    endif
+// Time between two VREFINT samples in ms
+#    ifndef EC_VREFINT_INTERVAL
+#        define EC_VREFINT_INTERVAL 1
+#    endif
+// VREFINT filter strength, each new sample weighs 1/2^shift
+#    ifndef EC_VREFINT_FILTER_SHIFT
+#        define EC_VREFINT_FILTER_SHIFT 3
+#    endif
+#endif
+
+#ifdef EC_TEMP_COMPENSATION_ENABLE
+// ADC channel of the temperature sensor, IN18 on the STM32F411
+#    ifndef EC_TEMP_SENSOR_CHANNEL
+#        define EC_TEMP_SENSOR_CHANNEL 18
+#    endif
+// Addresses of the factory temperature sensor readings at 30 and 110 degrees, 12 bits at 3.3 V
+#    ifndef EC_TEMP_CAL1_ADDR
+#        define EC_TEMP_CAL1_ADDR 0x1FFF7A2C
+#    endif
+#    ifndef EC_TEMP_CAL2_ADDR
+#        define EC_TEMP_CAL2_ADDR 0x1FFF7A2E
+#    endif
+// Shift from the switch reading resolution to the 12 bit factory readings
+#    ifndef EC_TEMP_CAL_SHIFT
+#        define EC_TEMP_CAL_SHIFT (12 - EC_ADC_BITS)
+#    endif
+// Sampling time of the temperature sensor conversions, in ADC clock cycles, at least 10 us on the STM32F411
+#    ifndef EC_TEMP_SAMPLING_TIME
+#        define EC_TEMP_SAMPLING_TIME ADC_SAMPLE_480
+#    endif
+// Time between two temperature samples and drift fit updates in ms
+#    ifndef EC_TEMP_INTERVAL
+#        define EC_TEMP_INTERVAL 1000
+#    endif
+// Temperature filter strength, each new sample weighs 1/2^shift
+#    ifndef EC_TEMP_FILTER_SHIFT
+#        define EC_TEMP_FILTER_SHIFT 2
+#    endif
+// Drift fit memory, each update weighs 1/2^shift
+#    ifndef EC_TEMP_FIT_SHIFT
+#        define EC_TEMP_FIT_SHIFT 6
+#    endif
+// Temperature excursion from the reference needed before the fitted drift is applied, in 0.1 degrees,
+// the fit must also have seen offsets of that size on average
+#    ifndef EC_TEMP_FIT_MIN_SPAN
+#        define EC_TEMP_FIT_MIN_SPAN 20
+#    endif
+#endif
+
+#ifdef EC_SOF_SYNC_ENABLE
+// Time between the end of a scan and the next USB start of frame in us
+#    ifndef EC_SOF_LEAD_US
+#        define EC_SOF_LEAD_US 50
+#    endif
+// Time between two measurements of the start of frame edge in ms, also between two lock attempts while unlocked
+#    ifndef EC_SOF_RESYNC_INTERVAL
+#        define EC_SOF_RESYNC_INTERVAL 100
+#    endif
+// Scan duration filter strength, each new scan weighs 1/2^shift
+#    ifndef EC_SOF_FILTER_SHIFT
+#        define EC_SOF_FILTER_SHIFT 3
+#    endif
+
+// Start of frame lock statistics, times in us
+typedef struct {
+    uint32_t scans;              // Scans aligned to the start of frame
+    uint32_t late;               // Scans that ended after their target start of frame
+    uint32_t resyncs;            // Start of frame edge measurements
+    uint16_t scan_avg_us;        // Filtered scan duration
+    uint16_t scan_max_us;        // Longest scan
+    uint16_t lead_avg_us;        // Filtered time from the end of a scan to the next start of frame
+    uint16_t lead_min_us;        // Shortest time from the end of a scan to the next start of frame
+    uint16_t phase_error_us;     // Start of frame prediction error at the last measurement
+    uint16_t phase_error_max_us; // Largest start of frame prediction error
+} ec_sof_stats_t;
+#endif
+
+#ifdef EC_FIXED_RATE_SCAN_ENABLE
+#    ifdef EC_SOF_SYNC_ENABLE
+#        error "EC_FIXED_RATE_SCAN_ENABLE and EC_SOF_SYNC_ENABLE both pace the scans, enable only one"
+#    endif
+// Time between the starts of two matrix scans in us, longer than a scan plus the main loop work
+#    ifndef EC_SCAN_INTERVAL_US
+#        define EC_SCAN_INTERVAL_US 1500
+#    endif
+
+// Fixed rate scan statistics, times in us
+typedef struct {
+    uint32_t scans;               // Scans started by the scan timer
+    uint32_t overruns;            // Timer ticks that fired while the previous one was still pending
+    uint16_t interval_min_us;     // Shortest time between the starts of two scans
+    uint16_t interval_max_us;     // Longest time between the starts of two scans
+    uint16_t jitter_us;           // Spread between the longest and shortest scan intervals
+    uint16_t wake_latency_us;     // Time from the last timer tick to the start of the scan
+    uint16_t wake_latency_max_us; // Longest time from a timer tick to the start of the scan
+} ec_fixed_rate_stats_t;
+#endif
+
+#ifdef ANALOG_PORTS
+// Sampling time of the reads converting the analog inputs of every AMUX, in ADC clock cycles
+#    ifndef EC_SCAN_SAMPLING_TIME
+#        define EC_SCAN_SAMPLING_TIME ADC_SAMPLE_144
+#    endif
+// Resolution of the reads converting the analog inputs of every AMUX, the same as single reads
+#    ifndef EC_SCAN_RESOLUTION
+#        define EC_SCAN_RESOLUTION EC_ADC_CR1_RESOLUTION
+#    endif
+#endif
+
+#ifdef EC_SCAN_TIMING_ENABLE
+// Scan loop timing filter strength, each new scan weighs 1/2^shift
+#    ifndef EC_SCAN_TIMING_FILTER_SHIFT
+#        define EC_SCAN_TIMING_FILTER_SHIFT 4
+#    endif
+
+// Scan loop timing statistics in cycles per scanned key, to compare builds such as the flash and SRAM scan paths
+typedef struct {
+    uint32_t scans;          // Measured scans
+    uint16_t key_cycles_min; // Fastest scan
+    uint16_t key_cycles_avg; // Filtered scan
+    uint16_t key_cycles_max; // Slowest scan
+} ec_scan_timing_stats_t;
+#endif
+
+#ifdef EC_TWO_TIER_SCAN_ENABLE
+// Sampling time of the coarse reads, in ADC clock cycles
+#    ifndef EC_COARSE_SAMPLING_TIME
+#        define EC_COARSE_SAMPLING_TIME ADC_SAMPLE_15
+#    endif
+// Resolution of the coarse reads
+#    ifndef EC_COARSE_RESOLUTION
+#        define EC_COARSE_RESOLUTION ADC_CR1_8B_RESOLUTION
+#    endif
+// Shift from the coarse read resolution to the switch reading resolution
+#    ifndef EC_COARSE_SHIFT
+#        define EC_COARSE_SHIFT (EC_ADC_BITS - 8)
+#    endif
+// Distance to a threshold under which a coarse reading is read again at full precision
+#    ifndef EC_COARSE_GUARD_BAND
+#        define EC_COARSE_GUARD_BAND (32 << EC_ADC_EXTRA_BITS)
+#    endif
+// Number of scans between two scans read entirely at full precision, feeding the statistics of the resting keys
+#    ifndef EC_COARSE_REFRESH_SCANS
+#        define EC_COARSE_REFRESH_SCANS 16
+#    endif
+#endif
+
+#ifdef EC_ONLINE_CALIBRATION_ENABLE
+// Largest rise of the bottom-out estimate per stroke, a single spike can't move it further
+#    ifndef EC_ONLINE_CAL_RISE
+#        define EC_ONLINE_CAL_RISE (4 << EC_ADC_EXTRA_BITS)
+#    endif
+// Decay of the bottom-out estimate towards shallower bottomed out strokes, each stroke closes 1/2^shift of the gap
+#    ifndef EC_ONLINE_CAL_DECAY_SHIFT
+#        define EC_ONLINE_CAL_DECAY_SHIFT 4
+#    endif
+// Strokes within 1/2^shift of the travel span below the estimate count as bottomed out
+#    ifndef EC_ONLINE_CAL_BAND_SHIFT
+#        define EC_ONLINE_CAL_BAND_SHIFT 3
+#    endif
+// Change of the estimate needed before the thresholds of the key are rescaled
+#    ifndef EC_ONLINE_CAL_MIN_CHANGE
+#        define EC_ONLINE_CAL_MIN_CHANGE (8 << EC_ADC_EXTRA_BITS)
+#    endif
+// Minimum depth past the noise floor of a stroke for a never calibrated key to count it
+#    ifndef EC_ONLINE_CAL_MIN_SPAN
+#        define EC_ONLINE_CAL_MIN_SPAN (200 << EC_ADC_EXTRA_BITS)
+#    endif
+// Strokes a never calibrated key needs before it adopts the deepest one as its bottom-out estimate
+#    ifndef EC_ONLINE_CAL_ADOPT_STROKES
+#        define EC_ONLINE_CAL_ADOPT_STROKES 8
+#    endif
+// Minimum time between two EEPROM writes of the tracked readings in ms
+#    ifndef EC_ONLINE_CAL_SAVE_INTERVAL
+#        define EC_ONLINE_CAL_SAVE_INTERVAL 600000
+#    endif
+#endif
+
+#ifdef EC_IDLE_SCAN_ENABLE
+// Time with every key in the noise band before entering the idle scan mode in ms,
+// 0 leaves the entry to ec_idle_scan_request()
+#    ifndef EC_IDLE_SCAN_TIMEOUT
+#        define EC_IDLE_SCAN_TIMEOUT 5000
+#    endif
+// Interval between two scans in the idle scan mode in ms
+#    ifndef EC_IDLE_SCAN_INTERVAL
+#        define EC_IDLE_SCAN_INTERVAL 10
+#    endif
+// Margin above the noise floor still considered idle
+#    ifndef EC_IDLE_NOISE_BAND
+#        define EC_IDLE_NOISE_BAND NOISE_FLOOR_THRESHOLD
+#    endif
+
+// Idle scan mode statistics, latencies in us
+typedef struct {
+    uint32_t entries;              // Times the idle scan mode was entered
+    uint16_t last_wake_latency_us; // Worst case detection delay of the last wake-up
+    uint16_t max_wake_latency_us;  // Maximum detection delay since boot
+} ec_idle_scan_stats_t;
+#endif
+
 typedef enum {
     // clang-format off
     RESCALE_MODE_APC = 0, // APC
@@ -52,35 +345,71 @@ typedef struct PACKED {
     bool    enabled;
 } indicator_config;
 
+// Number of indicators stored at the start of the EEPROM config
+#define EC_INDICATOR_COUNT 3
+
 // Runtime key state structure definitions
 typedef struct PACKED {
-    uint8_t  actuation_mode;             // 0: APC, 1: Rapid Trigger
-    uint16_t apc_actuation_threshold;    // APC actuation threshold
-    uint16_t apc_release_threshold;      // APC release threshold
-    uint16_t rt_initial_deadzone_offset; // RT initial deadzone offset
-    uint8_t  rt_actuation_offset;        // RT actuation offset
-    uint8_t  rt_release_offset;          // RT release offset
-
-    uint16_t rescaled_apc_actuation_threshold;    // Rescaled APC actuation threshold
-    uint16_t rescaled_apc_release_threshold;      // Rescaled APC release threshold
-    uint16_t rescaled_rt_initial_deadzone_offset; // Rescaled RT initial deadzone offset
-    uint8_t  rescaled_rt_actuation_offset;        // Rescaled RT actuation offset
-    uint8_t  rescaled_rt_release_offset;          // Rescaled RT release offset
-
-    uint16_t noise_floor;                   // Real time noise floor
-    uint16_t extremum;                      // Extremum value for RT
+    uint8_t     actuation_mode;             // 0: APC, 1: Rapid Trigger, 2: Velocity Rapid Trigger
+    uint16_t    apc_actuation_threshold;    // APC actuation threshold
+    uint16_t    apc_release_threshold;      // APC release threshold
+    uint16_t    rt_initial_deadzone_offset; // RT initial deadzone offset
+    ec_offset_t rt_actuation_offset;        // RT actuation offset
+    ec_offset_t rt_release_offset;          // RT release offset
+
+    uint16_t    rescaled_apc_actuation_threshold;    // Rescaled APC actuation threshold
+    uint16_t    rescaled_apc_release_threshold;      // Rescaled APC release threshold
+    uint16_t    rescaled_rt_initial_deadzone_offset; // Rescaled RT initial deadzone offset
+    ec_offset_t rescaled_rt_actuation_offset;        // Rescaled RT actuation offset
+    ec_offset_t rescaled_rt_release_offset;          // Rescaled RT release offset
+
+    uint16_t    noise_floor;     // Real time noise floor
+    ec_offset_t noise_amplitude; // Peak to peak noise at rest, derived from the noise statistics
+    ec_offset_t apc_hysteresis;  // Rescaled APC gap as configured, before the noise guard
+    ec_offset_t rt_hysteresis;   // Smaller rescaled RT offset as configured, before the noise guard
+    uint16_t    noise_count;     // Samples at rest in the noise statistics
+    uint32_t    noise_mean;      // Mean reading at rest, Q8
+    uint32_t    noise_m2;        // Sum of squared deviations at rest, Q8
+
+#ifdef EC_TEMP_COMPENSATION_ENABLE
+    uint16_t temp_base_floor; // Noise floor at the reference temperature
+    int32_t  temp_sxx;        // Weighted sum of squared temperature offsets, in (0.1 degree)^2
+    int32_t  temp_sxy;        // Weighted sum of temperature offset times resting level offset, in 0.1 degree * 1/16 count
+    uint16_t temp_sw;         // Weight sum of the fit, Q8
+#endif
+#ifdef EC_ONLINE_CALIBRATION_ENABLE
+    uint16_t stroke_peak;      // Deepest reading of the current stroke
+    uint16_t online_bottom;    // Bottom-out estimate tracked during normal use, 0 until the first stroke
+    uint16_t reference_bottom; // Bottom-out reading when the tracking started, for wear tracking
+    uint32_t stroke_count;     // Strokes since boot
+    uint16_t adopt_peak;       // Deepest counted stroke of a never calibrated key
+    uint8_t  adopt_strokes;    // Counted strokes of a never calibrated key
+#endif
+#ifdef EC_TRAVEL_THRESHOLDS_MM
+    uint16_t    travel_span;                // Readings from the noise floor to bottom-out, for the travel lookup
+    uint32_t    travel_scale;               // Reading to travel lookup index factor, Q16
+    ec_offset_t travel_min_offset;          // Noise guard in 0.01 mm at the RT initial deadzone
+    ec_offset_t travel_rt_actuation_offset; // RT actuation offset in 0.01 mm, after the noise guard
+    ec_offset_t travel_rt_release_offset;   // RT release offset in 0.01 mm, after the noise guard
+#endif
+    uint16_t extremum;                      // Extremum value for RT, a travel in 0.01 mm with EC_TRAVEL_THRESHOLDS_MM
     bool     bottoming_calibration_starter; // Flag to start bottoming calibration
     uint16_t bottoming_calibration_reading; // Bottoming reading for rescaling
+
+    int16_t  velocity;         // Filtered velocity in 1/256 10 bit counts per ms, positive towards bottom-out
+    uint16_t last_value;       // Previous reading, used for the velocity estimate
+    uint32_t last_sample;      // Cycle count of the previous reading
+    uint16_t sample_period_us; // Time between the last two readings
 } runtime_key_state_t;
 
 // EEPROM key state structure definitions (reduced parameters to save space, missing values are calculated at runtime)
 typedef struct PACKED {
-    uint8_t  actuation_mode;             // 0: APC, 1: Rapid Trigger
-    uint16_t apc_actuation_threshold;    // APC actuation threshold
-    uint16_t apc_release_threshold;      // APC release threshold
-    uint16_t rt_initial_deadzone_offset; // RT initial deadzone offset
-    uint8_t  rt_actuation_offset;        // RT actuation offset
-    uint8_t  rt_release_offset;          // RT release offset
+    uint8_t     actuation_mode;             // 0: APC, 1: Rapid Trigger, 2: Velocity Rapid Trigger
+    uint16_t    apc_actuation_threshold;    // APC actuation threshold
+    uint16_t    apc_release_threshold;      // APC release threshold
+    uint16_t    rt_initial_deadzone_offset; // RT initial deadzone offset
+    ec_offset_t rt_actuation_offset;        // RT actuation offset
+    ec_offset_t rt_release_offset;          // RT release offset
 
     uint16_t bottoming_calibration_reading; // Bottoming reading for rescaling
 } eeprom_key_state_t;
@@ -101,8 +430,10 @@ typedef struct PACKED {
 } eeprom_ec_config_t;
 
 // Compile-time check for EECONFIG_KB_DATA_SIZE
-// EECONFIG_KB_DATA_SIZE = 20 + (11 * MATRIX_ROWS * MATRIX_COLS)
+// EECONFIG_KB_DATA_SIZE = 38 + (11 * MATRIX_ROWS * MATRIX_COLS), 13 bytes per key with EC_ADC_12BIT
 _Static_assert(sizeof(eeprom_ec_config_t) == EECONFIG_KB_DATA_SIZE, "Mismatch in keyboard EECONFIG stored data");
+_Static_assert(offsetof(eeprom_ec_config_t, eeprom_key_state) == EC_INDICATOR_COUNT * sizeof(indicator_config), "Mismatch in indicator count");
+_Static_assert(EC_INDICATOR_COUNT <= 8, "Indicator mask doesn't fit in a single byte");
 
 // Extern declarations
 extern eeprom_ec_config_t  eeprom_ec_config;  // EEPROM configuration instance
@@ -113,33 +444,78 @@ extern socd_cleaner_t socd_opposing_pairs[4];
 
 // Function prototypes
 void init_row(void);
-void disable_unused_row(uint8_t row);
 void init_amux(void);
-void select_amux_channel(uint8_t channel, uint8_t col);
-void disable_unused_amux(uint8_t channel);
-void charge_capacitor(uint8_t row);
-void discharge_capacitor(void);
+
+// Scan hot path, EC_SCAN_HOT is repeated here so the callers in other files see the long_call too
+EC_SCAN_HOT void     disable_unused_row(uint8_t row);
+EC_SCAN_HOT void     select_amux_channel(uint8_t channel, uint8_t col);
+EC_SCAN_HOT void     disable_unused_amux(uint8_t channel);
+EC_SCAN_HOT void     charge_capacitor(uint8_t row);
+EC_SCAN_HOT void     discharge_capacitor(void);
+EC_SCAN_HOT bool     ec_matrix_scan(matrix_row_t current_matrix[]);
+EC_SCAN_HOT uint16_t ec_readkey_raw(uint8_t channel, uint8_t row, uint8_t col);
+EC_SCAN_HOT bool     ec_update_key(matrix_row_t *current_row, uint8_t row, uint8_t col, uint16_t sw_value);
+EC_SCAN_HOT bool     ec_update_key_apc(matrix_row_t *current_row, uint8_t col, uint16_t sw_value, runtime_key_state_t *key_runtime, bool pressed);
+EC_SCAN_HOT bool     ec_update_key_rt(matrix_row_t *current_row, uint8_t col, uint16_t sw_value, runtime_key_state_t *key_runtime, bool pressed);
+EC_SCAN_HOT bool     ec_update_key_vrt(matrix_row_t *current_row, uint8_t col, uint16_t sw_value, runtime_key_state_t *key_runtime, bool pressed);
 
 int      ec_init(void);
 void     ec_noise_floor_calibration(void);
-bool     ec_matrix_scan(matrix_row_t current_matrix[]);
-uint16_t ec_readkey_raw(uint8_t channel, uint8_t row, uint8_t col);
-bool     ec_update_key(matrix_row_t *current_row, uint8_t row, uint8_t col, uint16_t sw_value);
-bool     ec_update_key_apc(matrix_row_t *current_row, uint8_t col, uint16_t sw_value, runtime_key_state_t *key_runtime, bool pressed);
-bool     ec_update_key_rt(matrix_row_t *current_row, uint8_t col, uint16_t sw_value, runtime_key_state_t *key_runtime, bool pressed);
 void     bulk_rescale_key_thresholds(runtime_key_state_t *key_runtime, eeprom_key_state_t *key_eeprom, rescale_mode_t mode);
 void     update_keys_field(update_mode_t mode, size_t runtime_offset, size_t eeprom_offset, const void *value, size_t field_size);
 void     ec_print_matrix(void);
+uint16_t ec_get_sw_value(uint8_t row, uint8_t col);
+uint8_t  ec_get_key_depth(uint8_t row, uint8_t col);
+int16_t  ec_get_key_velocity(uint8_t row, uint8_t col);
+bool     ec_key_is_noisy(uint8_t row, uint8_t col);
+uint16_t ec_get_key_hysteresis(uint8_t row, uint8_t col);
+bool     ec_key_is_guarded(uint8_t row, uint8_t col);
+uint16_t ec_get_key_snr(uint8_t row, uint8_t col);
+#ifdef EC_TRAVEL_THRESHOLDS_MM
+uint16_t ec_get_key_travel(uint8_t row, uint8_t col);
+#endif
 uint16_t rescale(uint16_t x, uint16_t out_min, uint16_t out_max);
 
-#ifdef UNUSED_POSITIONS_LIST
-bool is_unused_position(uint8_t row, uint8_t col);
+#ifdef EC_IDLE_SCAN_ENABLE
+void                        ec_idle_scan_enter(void);
+void                        ec_idle_scan_request(bool idle);
+bool                        ec_idle_scan_active(void);
+const ec_idle_scan_stats_t *ec_idle_scan_get_stats(void);
+#endif
+
+#ifdef EC_VREFINT_ENABLE
+uint16_t ec_get_vdda_mv(void);
+#endif
+
+#ifdef EC_TEMP_COMPENSATION_ENABLE
+int16_t ec_get_temperature(void);
+int16_t ec_get_key_temp_drift(uint8_t row, uint8_t col);
+#endif
+
+#ifdef EC_SOF_SYNC_ENABLE
+const ec_sof_stats_t *ec_sof_get_stats(void);
+#endif
+
+#ifdef EC_FIXED_RATE_SCAN_ENABLE
+const ec_fixed_rate_stats_t *ec_fixed_rate_get_stats(void);
+#endif
+
+#ifdef EC_SCAN_TIMING_ENABLE
+const ec_scan_timing_stats_t *ec_scan_timing_get_stats(void);
+#endif
+
+#ifdef EC_ONLINE_CALIBRATION_ENABLE
+void    ec_online_calibration_task(void);
+void    ec_online_calibration_reset(void);
+int16_t ec_get_key_bottom_drift(uint8_t row, uint8_t col);
 #endif
 
-#ifdef SPLIT_KEYBOARD
-void via_cmd_slave_handler(uint8_t m2s_size, const void *m2s_buffer, uint8_t s2m_size, void *s2m_buffer);
+#ifdef UNUSED_POSITIONS_LIST
+EC_SCAN_HOT bool is_unused_position(uint8_t row, uint8_t col);
 #endif
 
 extern uint8_t   *pIndicators;
 indicator_config *get_indicator_p(int index);
 bool              indicators_callback(void);
+bool              indicators_update(layer_state_t state);
+void              indicators_refresh_colors(void);
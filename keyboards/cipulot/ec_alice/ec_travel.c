@@ -0,0 +1,74 @@
+/* Copyright 2026 Cipulot
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ec_travel.h"
+
+static const uint16_t travel_curve[EC_TRAVEL_CURVE_POINTS] = EC_TRAVEL_CURVE;
+
+// Travel in 0.01 mm of every normalized reading, built once from the curve
+uint16_t ec_travel_lut[EC_TRAVEL_LUT_SIZE];
+
+// Convert a travel in 0.01 mm to the reading of a key, used when rescaling thresholds
+uint16_t ec_travel_to_adc(uint16_t travel, uint16_t noise_floor, uint16_t bottom) {
+    if (bottom <= noise_floor || travel >= EC_TRAVEL_TOTAL) {
+        return bottom;
+    }
+
+    // Interpolate between the two surrounding curve points
+    uint32_t position   = (uint32_t)travel * (EC_TRAVEL_CURVE_POINTS - 1);
+    uint8_t  index      = position / EC_TRAVEL_TOTAL;
+    uint32_t fraction   = position % EC_TRAVEL_TOTAL;
+    uint32_t normalized = travel_curve[index] + (travel_curve[index + 1] - travel_curve[index]) * fraction / EC_TRAVEL_TOTAL;
+
+    return noise_floor + normalized * (bottom - noise_floor) / 1023;
+}
+
+// Convert a reading normalized to 0-1023 to a travel in 0.01 mm
+static uint16_t ec_normalized_to_travel(uint32_t normalized) {
+    // Find the curve segment holding the reading
+    uint8_t index = 0;
+    while (index < EC_TRAVEL_CURVE_POINTS - 2 && normalized >= travel_curve[index + 1]) {
+        index++;
+    }
+    uint16_t span     = travel_curve[index + 1] - travel_curve[index];
+    uint32_t fraction = span ? (normalized - travel_curve[index]) * EC_TRAVEL_TOTAL / span : 0;
+
+    return (index * EC_TRAVEL_TOTAL + fraction) / (EC_TRAVEL_CURVE_POINTS - 1);
+}
+
+// Build the travel lookup table used by the scan
+void ec_travel_init(void) {
+    for (uint16_t normalized = 0; normalized < EC_TRAVEL_LUT_SIZE; normalized++) {
+        ec_travel_lut[normalized] = ec_normalized_to_travel(normalized);
+    }
+}
+
+// Factor from a reading above the noise floor to a lookup table index for a key span, Q16
+uint32_t ec_travel_scale(uint16_t span) {
+    return span ? ((uint32_t)(EC_TRAVEL_LUT_SIZE - 1) << 16) / span : 0;
+}
+
+// Convert the reading of a key to a travel in 0.01 mm
+uint16_t ec_adc_to_travel(uint16_t value, uint16_t noise_floor, uint16_t bottom) {
+    if (value <= noise_floor || bottom <= noise_floor) {
+        return 0;
+    }
+    if (value >= bottom) {
+        return EC_TRAVEL_TOTAL;
+    }
+
+    return ec_normalized_to_travel((uint32_t)(value - noise_floor) * 1023 / (bottom - noise_floor));
+}
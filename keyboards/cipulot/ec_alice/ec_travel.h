@@ -0,0 +1,68 @@
+/* Copyright 2026 Cipulot
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+// Switch travel profiles
+#define EC_SWITCH_PROFILE_LINEAR 0 // Reading proportional to travel
+#define EC_SWITCH_PROFILE_TOPRE 1  // Topre dome and conical spring, 4 mm travel
+
+#ifndef EC_SWITCH_PROFILE
+#    define EC_SWITCH_PROFILE EC_SWITCH_PROFILE_TOPRE
+#endif
+
+// Number of points of a travel curve
+#define EC_TRAVEL_CURVE_POINTS 17
+
+// Travel curve: reading at evenly spaced travel steps, 0 at the noise floor to 1023 at bottom-out.
+// Must be strictly increasing. A custom curve can be set with EC_TRAVEL_CURVE and EC_TRAVEL_TOTAL.
+#ifndef EC_TRAVEL_CURVE
+#    if EC_SWITCH_PROFILE == EC_SWITCH_PROFILE_LINEAR
+#        define EC_TRAVEL_CURVE {0, 64, 128, 192, 256, 320, 384, 448, 512, 575, 639, 703, 767, 831, 895, 959, 1023}
+#    elif EC_SWITCH_PROFILE == EC_SWITCH_PROFILE_TOPRE
+#        define EC_TRAVEL_CURVE {0, 17, 35, 56, 79, 104, 133, 167, 205, 249, 301, 363, 438, 532, 651, 808, 1023}
+#    else
+#        error "Unknown EC_SWITCH_PROFILE"
+#    endif
+#endif
+
+// Total travel of the switch in 0.01 mm
+#ifndef EC_TRAVEL_TOTAL
+#    define EC_TRAVEL_TOTAL 400
+#endif
+
+// Entries of the travel lookup table, one per step of a reading normalized to 0-1023
+#define EC_TRAVEL_LUT_SIZE 1024
+
+extern uint16_t ec_travel_lut[EC_TRAVEL_LUT_SIZE];
+
+void     ec_travel_init(void);
+uint32_t ec_travel_scale(uint16_t span);
+uint16_t ec_travel_to_adc(uint16_t travel, uint16_t noise_floor, uint16_t bottom);
+uint16_t ec_adc_to_travel(uint16_t value, uint16_t noise_floor, uint16_t bottom);
+
+// Convert a reading to a travel in 0.01 mm through the lookup table, span and scale set at calibration
+static inline uint16_t ec_travel_lookup(uint16_t value, uint16_t noise_floor, uint16_t span, uint32_t scale) {
+    if (value <= noise_floor) {
+        return 0;
+    }
+    if (value - noise_floor >= span) {
+        return EC_TRAVEL_TOTAL;
+    }
+    return ec_travel_lut[((uint32_t)(value - noise_floor) * scale) >> 16];
+}
@@ -0,0 +1,201 @@
+/* Copyright 2026 Cipulot
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ec_ws2812.h"
+#include "ec_switch_matrix.h"
+#include "ws2812.h"
+#include "gpio.h"
+#include "hal.h"
+
+#ifndef WS2812_PWM_DRIVER
+#    define WS2812_PWM_DRIVER PWMD4
+#endif
+#ifndef WS2812_PWM_CHANNEL
+#    define WS2812_PWM_CHANNEL 2
+#endif
+#ifndef WS2812_PWM_PAL_MODE
+#    define WS2812_PWM_PAL_MODE 2
+#endif
+#ifndef WS2812_DMA_STREAM
+#    define WS2812_DMA_STREAM STM32_DMA1_STREAM6
+#endif
+// DMA channel of the TIM4 update request
+#ifndef WS2812_DMA_CHANNEL
+#    define WS2812_DMA_CHANNEL 2
+#endif
+
+// Bit timings in ns, reset time in us
+#ifndef WS2812_TIMING
+#    define WS2812_TIMING 1250
+#endif
+#ifndef WS2812_T0H
+#    define WS2812_T0H 350
+#endif
+#ifndef WS2812_T1H
+#    define WS2812_T1H 900
+#endif
+#ifndef WS2812_TRST_US
+#    define WS2812_TRST_US 280
+#endif
+// Scans a pending frame waits for a long enough gap before it is sent anyway
+#ifndef EC_WS2812_HOLD_SCANS
+#    define EC_WS2812_HOLD_SCANS 4
+#endif
+
+#define WS2812_PWM_FREQUENCY (STM32_SYSCLK / 2)
+#define WS2812_PWM_PERIOD (WS2812_PWM_FREQUENCY / (1000000000 / WS2812_TIMING))
+#define WS2812_DUTY_CYCLE_0 (WS2812_PWM_FREQUENCY / (1000000000 / WS2812_T0H))
+#define WS2812_DUTY_CYCLE_1 (WS2812_PWM_FREQUENCY / (1000000000 / WS2812_T1H))
+
+// Frame length in PWM periods: 24 color bits per LED, then the reset time with the line low
+#define WS2812_COLOR_BIT_N (WS2812_LED_COUNT * 24)
+#define WS2812_RESET_BIT_N (1000 * WS2812_TRST_US / WS2812_TIMING)
+#define WS2812_BIT_N (WS2812_COLOR_BIT_N + WS2812_RESET_BIT_N)
+// Time the line switches at the start of a frame, the reset time after it keeps the line low
+#define WS2812_COLOR_CYCLES EC_US_TO_CYCLES(WS2812_COLOR_BIT_N * WS2812_TIMING / 1000)
+
+// Colors set by rgblight, encoded only when the frame is sent
+typedef struct {
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+} ec_ws2812_led_t;
+
+static ec_ws2812_led_t           leds[WS2812_LED_COUNT];
+static uint16_t                  frame_buffer[WS2812_BIT_N]; // TIM4 is a 16 bit timer
+static const stm32_dma_stream_t *ws2812_dma;
+static volatile bool             transfer_busy = false; // Frame on the line, cleared by the DMA interrupt
+static uint32_t                  frame_start   = 0;     // Cycle count at the start of the frame on the line
+static bool                      frame_pending = false; // New colors waiting for the end of a scan
+static uint8_t                   frame_held    = 0;     // Scans the pending frame waited for a long enough gap
+static ec_ws2812_stats_t         ws2812_stats  = {0};
+
+// End of frame: stop the stream, the last duty cycle of 0 keeps the line low
+static void ec_ws2812_dma_complete(void *param, uint32_t flags) {
+    (void)param;
+    if (flags & STM32_DMA_ISR_TCIF) {
+        dmaStreamDisable(ws2812_dma);
+        transfer_busy = false;
+    }
+}
+
+// One-shot DMA frames, started by the matrix scan between two passes. The stock PWM driver
+// streams the frame buffer in a loop, so the LED line kept switching during the analog readings.
+void ws2812_init(void) {
+    palSetLineMode(WS2812_DI_PIN, PAL_MODE_ALTERNATE(WS2812_PWM_PAL_MODE) | PAL_STM32_OTYPE_PUSHPULL | PAL_STM32_OSPEED_HIGHEST);
+
+    static const PWMConfig ws2812_pwm_config = {
+        .frequency = WS2812_PWM_FREQUENCY,
+        .period    = WS2812_PWM_PERIOD,
+        .callback  = NULL,
+        .channels =
+            {
+                [0 ... 3]                = {.mode = PWM_OUTPUT_DISABLED, .callback = NULL},
+                [WS2812_PWM_CHANNEL - 1] = {.mode = PWM_OUTPUT_ACTIVE_HIGH, .callback = NULL},
+            },
+        .cr2  = 0,
+        .dier = TIM_DIER_UDE, // DMA request on each update event, one duty cycle per bit
+    };
+
+    // One-shot transfers into the duty cycle register, restarted for every frame
+    ws2812_dma = dmaStreamAlloc(WS2812_DMA_STREAM - STM32_DMA_STREAM(0), 10, ec_ws2812_dma_complete, NULL);
+    dmaStreamSetPeripheral(ws2812_dma, &(WS2812_PWM_DRIVER.tim->CCR[WS2812_PWM_CHANNEL - 1]));
+
+    pwmStart(&WS2812_PWM_DRIVER, &ws2812_pwm_config);
+    pwmEnableChannel(&WS2812_PWM_DRIVER, WS2812_PWM_CHANNEL - 1, 0);
+}
+
+void ws2812_set_color(int index, uint8_t red, uint8_t green, uint8_t blue) {
+    leds[index].r = red;
+    leds[index].g = green;
+    leds[index].b = blue;
+}
+
+void ws2812_set_color_all(uint8_t red, uint8_t green, uint8_t blue) {
+    for (uint8_t i = 0; i < WS2812_LED_COUNT; i++) {
+        ws2812_set_color(i, red, green, blue);
+    }
+}
+
+// Queue the frame, it goes out in the next gap between two matrix scans
+void ws2812_flush(void) {
+    frame_pending = true;
+}
+
+// Encode a color byte, most significant bit first
+static inline void ec_ws2812_write_byte(uint16_t *bits, uint8_t value) {
+    for (uint8_t bit = 0; bit < 8; bit++) {
+        bits[bit] = (value & (0x80 >> bit)) ? WS2812_DUTY_CYCLE_1 : WS2812_DUTY_CYCLE_0;
+    }
+}
+
+// Check if the LED line is switching, the reset time at the end of a frame is quiet
+bool ec_ws2812_busy(void) {
+    return transfer_busy && ec_cycle_count() - frame_start < WS2812_COLOR_CYCLES;
+}
+
+// Check if a reading taken now would overlap the LED line switching, the scan skips it and reads it again once the line is quiet
+bool ec_ws2812_tag_reading(void) {
+    if (!ec_ws2812_busy()) {
+        return false;
+    }
+    ws2812_stats.skipped++;
+    return true;
+}
+
+// Wait for the end of the color bits, at most one frame
+void ec_ws2812_wait(void) {
+    while (ec_ws2812_busy()) {
+    }
+}
+
+// Send the pending frame, called at the end of a matrix scan with the known wait before the next one
+void ec_ws2812_task(uint32_t gap_cycles) {
+    if (!frame_pending || transfer_busy) {
+        return;
+    }
+
+    // Keep the frame for a gap that covers the color bits, but not for long when the scans run back to back
+    if (gap_cycles < WS2812_COLOR_CYCLES) {
+        if (++frame_held < EC_WS2812_HOLD_SCANS) {
+            return;
+        }
+        ws2812_stats.overlapped++;
+    }
+    frame_held = 0;
+
+    // GRB order, the reset bits at the end of the buffer stay 0
+    for (uint8_t i = 0; i < WS2812_LED_COUNT; i++) {
+        ec_ws2812_write_byte(&frame_buffer[i * 24], leds[i].g);
+        ec_ws2812_write_byte(&frame_buffer[i * 24 + 8], leds[i].r);
+        ec_ws2812_write_byte(&frame_buffer[i * 24 + 16], leds[i].b);
+    }
+
+    frame_pending = false;
+    transfer_busy = true;
+    frame_start   = ec_cycle_count();
+    ws2812_stats.frames++;
+
+    dmaStreamSetMemory0(ws2812_dma, frame_buffer);
+    dmaStreamSetTransactionSize(ws2812_dma, WS2812_BIT_N);
+    dmaStreamSetMode(ws2812_dma, STM32_DMA_CR_CHSEL(WS2812_DMA_CHANNEL) | STM32_DMA_CR_DIR_M2P | STM32_DMA_CR_PSIZE_HWORD | STM32_DMA_CR_MSIZE_HWORD | STM32_DMA_CR_MINC | STM32_DMA_CR_PL(3) | STM32_DMA_CR_TCIE);
+    dmaStreamEnable(ws2812_dma);
+}
+
+// Get the frame scheduling statistics
+const ec_ws2812_stats_t *ec_ws2812_get_stats(void) {
+    return &ws2812_stats;
+}
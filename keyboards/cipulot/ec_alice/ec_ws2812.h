@@ -0,0 +1,33 @@
+/* Copyright 2026 Cipulot
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// LED frame scheduling statistics
+typedef struct {
+    uint32_t frames;     // Frames sent
+    uint32_t overlapped; // Frames sent without a wait before the next scan that covers them
+    uint32_t skipped;    // Readings skipped while the LED line was switching, read again before the end of the scan
+} ec_ws2812_stats_t;
+
+bool                     ec_ws2812_busy(void);
+bool                     ec_ws2812_tag_reading(void);
+void                     ec_ws2812_wait(void);
+void                     ec_ws2812_task(uint32_t gap_cycles);
+const ec_ws2812_stats_t *ec_ws2812_get_stats(void);
@@ -20,4 +20,8 @@
 #define HAL_USE_PAL TRUE
 #define HAL_USE_PWM TRUE
 
+#ifdef EC_FIXED_RATE_SCAN_ENABLE
+#    define HAL_USE_GPT TRUE
+#endif
+
 #include_next <halconf.h>
@@ -1,3 +1,5 @@
 #define RGBLIGHT_SLEEP  // allows us to use rgblight_suspend() and rgblight_wakeup() in keymap.c
 //#define RGBLIGHT_TIMEOUT 60000  // 1 min (60 seconds)
 #define RGBLIGHT_TIMEOUT 600000
+#define TAPPING_TERM_PER_KEY  // depth-aware tap/hold in ec_tap_hold.c
+#define EC_IDLE_SCAN_TIMEOUT 0  // idle scan entered from the idle manager stages in keymap.c
@@ -0,0 +1,89 @@
+/* Copyright 2026 Cipulot
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ec_tap_hold.h"
+#include "ec_switch_matrix.h"
+#include "keycodes.h"
+#include "timer.h"
+
+// Time each key went deep, 0 while the key is shallow
+static uint16_t deep_since[MATRIX_ROWS][MATRIX_COLS];
+
+// Position of the tap dance keys being held, tap dance resolves with an empty record
+static struct {
+    uint16_t keycode;
+    keypos_t key;
+} td_keys[EC_TAP_HOLD_TD_SLOTS];
+
+// Restart the depth dwell of each press and track the position of the tap dance keys, call from process_record_user()
+void ec_tap_hold_process_record(uint16_t keycode, keyrecord_t *record) {
+    // A Rapid Trigger release and press can stay deep, so the dwell restarts on every press and release
+    if (record->event.key.row < MATRIX_ROWS && record->event.key.col < MATRIX_COLS) {
+        deep_since[record->event.key.row][record->event.key.col] = 0;
+    }
+
+    if (!IS_QK_TAP_DANCE(keycode)) {
+        return;
+    }
+
+    for (uint8_t i = 0; i < EC_TAP_HOLD_TD_SLOTS; i++) {
+        if (record->event.pressed && td_keys[i].keycode == KC_NO) {
+            td_keys[i].keycode = keycode;
+            td_keys[i].key     = record->event.key;
+            return;
+        }
+        if (!record->event.pressed && td_keys[i].keycode == keycode) {
+            td_keys[i].keycode = KC_NO;
+            return;
+        }
+    }
+}
+
+// Check if a key stayed deep long enough to be a hold
+static bool ec_tap_hold_is_deep(keypos_t key) {
+    if (key.row >= MATRIX_ROWS || key.col >= MATRIX_COLS) {
+        return false;
+    }
+
+    if (ec_get_key_depth(key.row, key.col) < EC_TAP_HOLD_DEPTH) {
+        deep_since[key.row][key.col] = 0;
+        return false;
+    }
+    if (deep_since[key.row][key.col] == 0) {
+        // 0 marks a shallow key, nudge the timestamp off it
+        deep_since[key.row][key.col] = timer_read() | 1;
+        return false;
+    }
+    return timer_elapsed(deep_since[key.row][key.col]) >= EC_TAP_HOLD_DWELL;
+}
+
+// Tapping term of a dual-role key, 0 once the key dwells deep so the hold happens on the next tick
+uint16_t ec_tap_hold_get_tapping_term(uint16_t keycode, keyrecord_t *record, uint16_t tapping_term) {
+    if (IS_QK_TAP_DANCE(keycode)) {
+        for (uint8_t i = 0; i < EC_TAP_HOLD_TD_SLOTS; i++) {
+            if (td_keys[i].keycode == keycode) {
+                return ec_tap_hold_is_deep(td_keys[i].key) ? 0 : tapping_term;
+            }
+        }
+        return tapping_term;
+    }
+
+    if (IS_QK_LAYER_TAP(keycode) || IS_QK_MOD_TAP(keycode)) {
+        return ec_tap_hold_is_deep(record->event.key) ? 0 : tapping_term;
+    }
+
+    return tapping_term;
+}
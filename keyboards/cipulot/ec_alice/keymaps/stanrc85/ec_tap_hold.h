@@ -0,0 +1,37 @@
+/* Copyright 2026 Cipulot
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "action.h"
+
+// Depth past which a dual-role key is considered deep, 0 at rest to 255 at bottom-out
+#ifndef EC_TAP_HOLD_DEPTH
+#    define EC_TAP_HOLD_DEPTH 200
+#endif
+
+// Time a dual-role key has to stay deep before it resolves as hold in ms
+#ifndef EC_TAP_HOLD_DWELL
+#    define EC_TAP_HOLD_DWELL 40
+#endif
+
+// Number of tap dance keys tracked at the same time
+#ifndef EC_TAP_HOLD_TD_SLOTS
+#    define EC_TAP_HOLD_TD_SLOTS 4
+#endif
+
+void     ec_tap_hold_process_record(uint16_t keycode, keyrecord_t *record);
+uint16_t ec_tap_hold_get_tapping_term(uint16_t keycode, keyrecord_t *record, uint16_t tapping_term);
@@ -15,7 +15,10 @@
  */
 
 #include QMK_KEYBOARD_H
+#include "shift_caps.h"
+#include "idle_manager.h"
 #include "keyboards/cipulot/ec_alice/ec_switch_matrix.h"
+#include "ec_tap_hold.h"
 
 // Tap dance: double-tap Left Shift to toggle Caps Lock
 enum {
@@ -23,42 +26,16 @@ enum {
   TD_ALT_SPC_LGUI,
 };
 
-void dance_lshift_caps_finished(tap_dance_state_t *state, void *user_data);
-void dance_lshift_caps_reset(tap_dance_state_t *state, void *user_data);
-
 void dance_alt_spc_finished(tap_dance_state_t *state, void *user_data);
 void dance_alt_spc_reset(tap_dance_state_t *state, void *user_data);
 
 tap_dance_action_t tap_dance_actions[] = {
-  [TD_LSFT_CAPS] = ACTION_TAP_DANCE_FN_ADVANCED(NULL, dance_lshift_caps_finished, dance_lshift_caps_reset),
+  [TD_LSFT_CAPS] = ACTION_TAP_DANCE_SHIFT_CAPS(),
   [TD_ALT_SPC_LGUI] = ACTION_TAP_DANCE_FN_ADVANCED(NULL, dance_alt_spc_finished, dance_alt_spc_reset),
 };
 
-static bool lsft_registered = false;
 static bool lgui_registered = false;
 
-void dance_lshift_caps_finished(tap_dance_state_t *state, void *user_data) {
-  if (state->count == 1) {
-    // Single tap: behave as regular Shift when held, or a tap when quickly pressed
-    if (state->pressed) {
-      register_code(KC_LSFT);
-      lsft_registered = true;
-    } else {
-      tap_code(KC_LSFT);
-    }
-  } else if (state->count == 2) {
-    // Double tap: toggle Caps Lock
-    tap_code(KC_CAPS);
-  }
-}
-
-void dance_lshift_caps_reset(tap_dance_state_t *state, void *user_data) {
-  if (lsft_registered) {
-    unregister_code(KC_LSFT);
-    lsft_registered = false;
-  }
-}
-
 void dance_alt_spc_finished(tap_dance_state_t *state, void *user_data) {
   if (state->count == 1) {
     if (state->pressed) {
@@ -84,49 +61,29 @@ void dance_alt_spc_reset(tap_dance_state_t *state, void *user_data) {
   }
 }
 
-//RGB Timeout
-
-static uint32_t key_timer; // timer to track the last keyboard activity
-static void refresh_rgb(void); // refreshes the activity timer and RGB, invoke whenever activity happens
-static void check_rgb_timeout(void); // checks if enough time has passed for RGB to timeout
-bool is_rgb_timeout = false; // store if RGB has timed out or not in a boolean
-
-
-void refresh_rgb() {
-  key_timer = timer_read32(); // store time of last refresh
-  if (is_rgb_timeout) { // only do something if rgb has timed out
-    print("Activity detected, turning on RGB\n");
-    is_rgb_timeout = false;
-    rgblight_wakeup();
-  }
+void housekeeping_task_user(void) {
+  idle_manager_task();
 }
 
-void check_rgb_timeout() {
-  if (!is_rgb_timeout && timer_elapsed32(key_timer) > RGBLIGHT_TIMEOUT) {
-    rgblight_suspend();
-    print("Idle timeout reached, turning off RGB\n");
-    is_rgb_timeout = true;
-  }
+#ifdef EC_IDLE_SCAN_ENABLE
+//Scan the matrix at the reduced rate while the idle manager reports the keyboard idle
+static void idle_scan_transition(idle_stage_t old_stage, idle_stage_t new_stage) {
+  ec_idle_scan_request(new_stage != IDLE_STAGE_ACTIVE);
 }
 
-
-void housekeeping_task_user(void) {
-  #ifdef RGBLIGHT_TIMEOUT
-  check_rgb_timeout();
-  #endif
+void keyboard_post_init_user(void) {
+  idle_manager_subscribe(idle_scan_transition);
 }
+#endif
 
-void post_process_record_user(uint16_t keycode, keyrecord_t *record) {
-  #ifdef RGBLIGHT_TIMEOUT
-  if (record->event.pressed) refresh_rgb();
-  #endif
+//Depth-aware tap/hold: deep presses resolve as hold before the tapping term
+bool process_record_user(uint16_t keycode, keyrecord_t *record) {
+  ec_tap_hold_process_record(keycode, record);
+  return true;
 }
 
-
-void post_encoder_update_user(uint8_t index, bool clockwise) {
-  #ifdef RGBLIGHT_TIMEOUT
-  refresh_rgb();
-  #endif
+uint16_t get_tapping_term(uint16_t keycode, keyrecord_t *record) {
+  return ec_tap_hold_get_tapping_term(keycode, record, TAPPING_TERM);
 }
 
 enum my_layers {
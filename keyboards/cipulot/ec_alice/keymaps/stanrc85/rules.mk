@@ -1,3 +1,12 @@
 VIA_ENABLE = yes
 SRC += via_ec_indicators.c
+SRC += ec_tap_hold.c
 TAP_DANCE_ENABLE = yes
+EC_ANALOG_STREAM_ENABLE = yes
+IDLE_MANAGER_ENABLE = yes
+EC_IDLE_SCAN_ENABLE = yes
+SHIFT_CAPS_ENABLE = yes
+EC_ONLINE_CALIBRATION_ENABLE = yes
+EC_VREFINT_ENABLE = yes
+EC_TEMP_COMPENSATION_ENABLE = yes
+EC_WS2812_SCHEDULED = yes
@@ -14,14 +14,25 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "ec_switch_matrix.h"
+#include "ec_log.h"
 #include "action.h"
-#include "print.h"
 #include "via.h"
 #include <string.h>
 
 #ifdef SPLIT_KEYBOARD
-#    include "transactions.h"
-#    include "usb_descriptor.h"
+#    include "ec_split.h"
+#endif
+
+#ifdef EC_ANALOG_STREAM_ENABLE
+#    include "ec_analog_stream.h"
+#endif
+
+#ifdef EC_MIDI_ENABLE
+#    include "ec_midi.h"
+#endif
+
+#ifdef EC_TRAVEL_THRESHOLDS_MM
+#    include "ec_travel.h"
 #endif
 
 #ifdef VIA_ENABLE
@@ -32,6 +43,9 @@ static void     ec_save_bottoming_calibration_reading(void);
 static void     ec_show_calibration_data(void);
 static void     ec_clear_bottoming_calibration_data(void);
 static uint16_t socd_pair_handler(bool mode, uint8_t pair_idx, uint8_t field, uint16_t value);
+static uint16_t ec_via_to_threshold(uint16_t value);
+static uint16_t ec_threshold_to_via(uint16_t threshold);
+static uint16_t ec_via_to_offset(uint16_t value);
 
 // Declaring enums for VIA config menu
 enum via_enums {
@@ -70,7 +84,8 @@ enum via_enums {
     id_socd_pair_3_key_2 = 32,
     id_socd_pair_4_mode = 33,
     id_socd_pair_4_key_1 = 34,
-    id_socd_pair_4_key_2 = 35
+    id_socd_pair_4_key_2 = 35,
+    id_guarded_key_count = 36
     // clang-format on
 };
 
@@ -87,7 +102,7 @@ void via_config_set_value(uint8_t *data) {
 // Forward the same data to the slave side in case of split keyboard
 #    ifdef SPLIT_KEYBOARD
     if (is_keyboard_master()) {
-        transaction_rpc_send(RPC_ID_VIA_CMD, RAW_EPSIZE - 2, data);
+        ec_split_queue_config(data);
     }
 #    endif
     if ((*value_id) < id_actuation_mode) {
@@ -149,6 +164,7 @@ void via_config_set_value(uint8_t *data) {
                 break;
             }
         }
+        indicators_refresh_colors();
         indicators_callback();
     } else {
         switch (*value_id) {
@@ -158,44 +174,51 @@ void via_config_set_value(uint8_t *data) {
                 update_keys_field(EC_UPDATE_SHARED_OFFSET, offsetof(runtime_key_state_t, actuation_mode), 0, &value, sizeof(uint8_t));
                 eeconfig_update_kb_datablock_field(eeprom_ec_config, eeprom_key_state);
                 if (value == 0) {
-                    uprintf("#########################\n");
-                    uprintf("#  Actuation Mode: APC  #\n");
-                    uprintf("#########################\n");
+                    ec_log(EC_LOG_ACTUATION_MODE_APC, 0, 0);
                 } else if (value == 1) {
-                    uprintf("#################################\n");
-                    uprintf("# Actuation Mode: Rapid Trigger #\n");
-                    uprintf("#################################\n");
+                    ec_log(EC_LOG_ACTUATION_MODE_RT, 0, 0);
+                } else if (value == 2) {
+                    ec_log(EC_LOG_ACTUATION_MODE_VRT, 0, 0);
                 }
+                indicators_callback();
                 break;
             }
             case id_apc_actuation_threshold: {
-                uint16_t value = value_data[1] | (value_data[0] << 8);
+                uint16_t value = ec_via_to_threshold(value_data[1] | (value_data[0] << 8));
                 update_keys_field(EC_UPDATE_RUNTIME_ONLY, offsetof(runtime_key_state_t, apc_actuation_threshold), 0, &value, sizeof(uint16_t));
-                uprintf("APC Mode Actuation Threshold: %d\n", value);
+                ec_log(EC_LOG_APC_ACTUATION_THRESHOLD, value, 0);
                 break;
             }
             case id_apc_release_threshold: {
-                uint16_t value = value_data[1] | (value_data[0] << 8);
+                uint16_t value = ec_via_to_threshold(value_data[1] | (value_data[0] << 8));
                 update_keys_field(EC_UPDATE_RUNTIME_ONLY, offsetof(runtime_key_state_t, apc_release_threshold), 0, &value, sizeof(uint16_t));
-                uprintf("APC Mode Release Threshold: %d\n", value);
+                ec_log(EC_LOG_APC_RELEASE_THRESHOLD, value, 0);
                 break;
             }
             case id_rt_initial_deadzone_offset: {
-                uint16_t value = value_data[1] | (value_data[0] << 8);
+                uint16_t value = ec_via_to_threshold(value_data[1] | (value_data[0] << 8));
                 update_keys_field(EC_UPDATE_RUNTIME_ONLY, offsetof(runtime_key_state_t, rt_initial_deadzone_offset), 0, &value, sizeof(uint16_t));
-                uprintf("Rapid Trigger Mode Initial Deadzone Offset: %d\n", value);
+                ec_log(EC_LOG_RT_INITIAL_DEADZONE_OFFSET, value, 0);
                 break;
             }
             case id_rt_actuation_offset: {
-                uint8_t value = value_data[0];
-                update_keys_field(EC_UPDATE_RUNTIME_ONLY, offsetof(runtime_key_state_t, rt_actuation_offset), 0, &value, sizeof(uint8_t));
-                uprintf("Rapid Trigger Mode Actuation Offset: %d\n", value);
+#    ifdef EC_ADC_12BIT
+                ec_offset_t value = ec_via_to_offset(value_data[1] | (value_data[0] << 8));
+#    else
+                ec_offset_t value = ec_via_to_offset(value_data[0]);
+#    endif
+                update_keys_field(EC_UPDATE_RUNTIME_ONLY, offsetof(runtime_key_state_t, rt_actuation_offset), 0, &value, sizeof(ec_offset_t));
+                ec_log(EC_LOG_RT_ACTUATION_OFFSET, value, 0);
                 break;
             }
             case id_rt_release_offset: {
-                uint8_t value = value_data[0];
-                update_keys_field(EC_UPDATE_RUNTIME_ONLY, offsetof(runtime_key_state_t, rt_release_offset), 0, &value, sizeof(uint8_t));
-                uprintf("Rapid Trigger Mode Release Offset: %d\n", value);
+#    ifdef EC_ADC_12BIT
+                ec_offset_t value = ec_via_to_offset(value_data[1] | (value_data[0] << 8));
+#    else
+                ec_offset_t value = ec_via_to_offset(value_data[0]);
+#    endif
+                update_keys_field(EC_UPDATE_RUNTIME_ONLY, offsetof(runtime_key_state_t, rt_release_offset), 0, &value, sizeof(ec_offset_t));
+                ec_log(EC_LOG_RT_RELEASE_OFFSET, value, 0);
                 break;
             }
             case id_bottoming_calibration: {
@@ -205,17 +228,16 @@ void via_config_set_value(uint8_t *data) {
                     // Set the bottoming calibration flag to true
                     runtime_ec_config.bottoming_calibration = true;
                     clear_keyboard();
-                    uprintf("##############################\n");
-                    uprintf("# Bottoming calibration mode #\n");
-                    uprintf("##############################\n");
+                    ec_log(EC_LOG_BOTTOMING_CALIBRATION_START, 0, 0);
                 } else {
                     // Set the bottoming calibration flag to false and save readings
                     runtime_ec_config.bottoming_calibration = false;
                     clear_keyboard();
                     ec_save_bottoming_calibration_reading();
-                    uprintf("## Bottoming calibration done ##\n");
+                    ec_log(EC_LOG_BOTTOMING_CALIBRATION_DONE, 0, 0);
                     ec_show_calibration_data();
                 }
+                indicators_callback();
                 break;
             }
             case id_save_threshold_data: {
@@ -229,9 +251,7 @@ void via_config_set_value(uint8_t *data) {
                 if (value == 0) {
                     // Perform noise floor calibration
                     ec_noise_floor_calibration(); // Note: noise floor calibration already rescales thresholds
-                    uprintf("#############################\n");
-                    uprintf("# Noise floor data acquired #\n");
-                    uprintf("#############################\n");
+                    ec_log(EC_LOG_NOISE_FLOOR_ACQUIRED, 0, 0);
                     break;
                 }
                 break;
@@ -242,6 +262,7 @@ void via_config_set_value(uint8_t *data) {
                     // Show calibration data
                     ec_show_calibration_data();
                 }
+                indicators_callback();
                 break;
             }
             case id_clear_bottoming_calibration_data: {
@@ -341,26 +362,36 @@ void via_config_get_value(uint8_t *data) {
                 break;
             }
             case id_apc_actuation_threshold: {
-                value_data[0] = key_runtime->apc_actuation_threshold >> 8;
-                value_data[1] = key_runtime->apc_actuation_threshold & 0xFF;
+                value_data[0] = ec_threshold_to_via(key_runtime->apc_actuation_threshold) >> 8;
+                value_data[1] = ec_threshold_to_via(key_runtime->apc_actuation_threshold) & 0xFF;
                 break;
             }
             case id_apc_release_threshold: {
-                value_data[0] = key_runtime->apc_release_threshold >> 8;
-                value_data[1] = key_runtime->apc_release_threshold & 0xFF;
+                value_data[0] = ec_threshold_to_via(key_runtime->apc_release_threshold) >> 8;
+                value_data[1] = ec_threshold_to_via(key_runtime->apc_release_threshold) & 0xFF;
                 break;
             }
             case id_rt_initial_deadzone_offset: {
-                value_data[0] = key_runtime->rt_initial_deadzone_offset >> 8;
-                value_data[1] = key_runtime->rt_initial_deadzone_offset & 0xFF;
+                value_data[0] = ec_threshold_to_via(key_runtime->rt_initial_deadzone_offset) >> 8;
+                value_data[1] = ec_threshold_to_via(key_runtime->rt_initial_deadzone_offset) & 0xFF;
                 break;
             }
             case id_rt_actuation_offset: {
+#    ifdef EC_ADC_12BIT
+                value_data[0] = key_runtime->rt_actuation_offset >> 8;
+                value_data[1] = key_runtime->rt_actuation_offset & 0xFF;
+#    else
                 value_data[0] = key_runtime->rt_actuation_offset;
+#    endif
                 break;
             }
             case id_rt_release_offset: {
+#    ifdef EC_ADC_12BIT
+                value_data[0] = key_runtime->rt_release_offset >> 8;
+                value_data[1] = key_runtime->rt_release_offset & 0xFF;
+#    else
                 value_data[0] = key_runtime->rt_release_offset;
+#    endif
                 break;
             }
             case id_socd_pair_1_mode:
@@ -415,6 +446,21 @@ void via_config_get_value(uint8_t *data) {
                 value_data[0]    = socd_pair_result >> 8;
                 value_data[1]    = socd_pair_result & 0xFF;
                 break;
+            case id_guarded_key_count: {
+                // Read only: keys whose hysteresis the noise guard raised above the configured one
+                uint16_t guarded = 0;
+                for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+                    for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+#    ifdef UNUSED_POSITIONS_LIST
+                        if (is_unused_position(row, col)) continue;
+#    endif
+                        guarded += ec_key_is_guarded(row, col);
+                    }
+                }
+                value_data[0] = guarded >> 8;
+                value_data[1] = guarded & 0xFF;
+                break;
+            }
             default: {
                 // Unhandled value.
                 break;
@@ -456,6 +502,25 @@ void via_custom_value_command_kb(uint8_t *data, uint8_t length) {
     *command_id = id_unhandled;
 }
 
+// Handle the raw HID commands that are not part of the VIA protocol
+bool via_command_kb(uint8_t *data, uint8_t length) {
+#    ifdef EC_ANALOG_STREAM_ENABLE
+    // Analog stream control
+    if (ec_analog_stream_command(data, length)) {
+        return true;
+    }
+#    endif
+
+#    ifdef EC_MIDI_ENABLE
+    // MIDI mode control
+    if (ec_midi_command(data, length)) {
+        return true;
+    }
+#    endif
+
+    return false;
+}
+
 // Handle the application of new threshold data and save to EEPROM
 static void ec_save_threshold_data(uint8_t option) {
     // Save APC mode thresholds and rescale them for runtime usage
@@ -489,9 +554,7 @@ static void ec_save_threshold_data(uint8_t option) {
     }
     // Save to EEPROM the eeprom_key_state field
     eeconfig_update_kb_datablock_field(eeprom_ec_config, eeprom_key_state);
-    uprintf("####################################\n");
-    uprintf("# New thresholds applied and saved #\n");
-    uprintf("####################################\n");
+    ec_log(EC_LOG_THRESHOLDS_SAVED, 0, 0);
 }
 
 // Handle the application of the bottoming calibration data and save to EEPROM
@@ -504,15 +567,15 @@ static void ec_save_bottoming_calibration_reading(void) {
 
             // Validate bottoming calibration reading before saving:
             // 1. If starter flag is still true: key never exceeded noise_floor + threshold during calibration
-            //    → Key was not pressed or is physically absent → save 1023 (max ADC value)
+            //    → Key was not pressed or is physically absent → save EC_ADC_MAX (max ADC value)
             // 2. If starter flag is false but reading is below noise_floor + threshold: weak/invalid reading
-            //    → Likely unpressed alternative layout key or noise spike during init → save 1023
+            //    → Likely unpressed alternative layout key or noise spike during init → save EC_ADC_MAX
             // 3. Otherwise: valid bottom-out peak captured → save actual reading
-            // Setting 1023 for invalid keys ensures their rescaled thresholds don't become unreasonably low
+            // Setting EC_ADC_MAX for invalid keys ensures their rescaled thresholds don't become unreasonably low
             if (key_runtime->bottoming_calibration_starter || key_runtime->bottoming_calibration_reading < (key_runtime->noise_floor + BOTTOMING_CALIBRATION_THRESHOLD)) {
                 // Save max ADC value for invalid/no-press keys
-                key_runtime->bottoming_calibration_reading = 1023;
-                key_eeprom->bottoming_calibration_reading  = 1023;
+                key_runtime->bottoming_calibration_reading = EC_ADC_MAX;
+                key_eeprom->bottoming_calibration_reading  = EC_ADC_MAX;
                 // Rescale thresholds based on max bottoming value
                 bulk_rescale_key_thresholds(key_runtime, key_eeprom, RESCALE_MODE_ALL);
             } else {
@@ -525,110 +588,15 @@ static void ec_save_bottoming_calibration_reading(void) {
     }
     // Save to EEPROM the eeprom_key_state field
     eeconfig_update_kb_datablock_field(eeprom_ec_config, eeprom_key_state);
+#ifdef EC_ONLINE_CALIBRATION_ENABLE
+    // Track from the new readings
+    ec_online_calibration_reset();
+#endif
 }
 
-// Show the calibration data
+// Show the calibration data (queued, printed from housekeeping)
 static void ec_show_calibration_data(void) {
-    uprintf("\n##################\n");
-    uprintf("# Actuation Mode #\n");
-    uprintf("##################\n");
-    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
-        for (uint8_t col = 0; col < MATRIX_COLS - 1; col++) {
-            uprintf("%4d,", eeprom_ec_config.eeprom_key_state[row][col].actuation_mode);
-        }
-        uprintf("%4d\n", eeprom_ec_config.eeprom_key_state[row][MATRIX_COLS - 1].actuation_mode);
-    }
-
-    uprintf("\n###############\n");
-    uprintf("# Noise Floor #\n");
-    uprintf("###############\n");
-    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
-        for (uint8_t col = 0; col < MATRIX_COLS - 1; col++) {
-            uprintf("%4d,", runtime_ec_config.runtime_key_state[row][col].noise_floor);
-        }
-        uprintf("%4d\n", runtime_ec_config.runtime_key_state[row][MATRIX_COLS - 1].noise_floor);
-    }
-
-    uprintf("\n############\n");
-    uprintf("# Extremum #\n");
-    uprintf("############\n");
-    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
-        for (uint8_t col = 0; col < MATRIX_COLS - 1; col++) {
-            uprintf("%4d,", runtime_ec_config.runtime_key_state[row][col].extremum);
-        }
-        uprintf("%4d\n", runtime_ec_config.runtime_key_state[row][MATRIX_COLS - 1].extremum);
-    }
-
-    uprintf("\n######################\n");
-    uprintf("# Bottoming Readings #\n");
-    uprintf("######################\n");
-    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
-        for (uint8_t col = 0; col < MATRIX_COLS - 1; col++) {
-            uprintf("%4d,", runtime_ec_config.runtime_key_state[row][col].bottoming_calibration_reading);
-        }
-        uprintf("%4d\n", runtime_ec_config.runtime_key_state[row][MATRIX_COLS - 1].bottoming_calibration_reading);
-    }
-
-    uprintf("\n######################################\n");
-    uprintf("# APC Mode Actuation Threshold       #\n");
-    uprintf("######################################\n");
-    uprintf("Original Value: %4d\n", eeprom_ec_config.eeprom_key_state[0][0].apc_actuation_threshold);
-    uprintf("Rescaled Values:\n");
-    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
-        for (uint8_t col = 0; col < MATRIX_COLS - 1; col++) {
-            uprintf("%4d,", runtime_ec_config.runtime_key_state[row][col].rescaled_apc_actuation_threshold);
-        }
-        uprintf("%4d\n", runtime_ec_config.runtime_key_state[row][MATRIX_COLS - 1].rescaled_apc_actuation_threshold);
-    }
-
-    uprintf("\n######################################\n");
-    uprintf("# APC Mode Release Threshold         #\n");
-    uprintf("######################################\n");
-    uprintf("Original Value: %4d\n", eeprom_ec_config.eeprom_key_state[0][0].apc_release_threshold);
-    uprintf("Rescaled Values:\n");
-    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
-        for (uint8_t col = 0; col < MATRIX_COLS - 1; col++) {
-            uprintf("%4d,", runtime_ec_config.runtime_key_state[row][col].rescaled_apc_release_threshold);
-        }
-        uprintf("%4d\n", runtime_ec_config.runtime_key_state[row][MATRIX_COLS - 1].rescaled_apc_release_threshold);
-    }
-
-    uprintf("\n#######################################################\n");
-    uprintf("# Rapid Trigger Mode Initial Deadzone Offset          #\n");
-    uprintf("#######################################################\n");
-    uprintf("Original Value: %4d\n", eeprom_ec_config.eeprom_key_state[0][0].rt_initial_deadzone_offset);
-    uprintf("Rescaled Values:\n");
-    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
-        for (uint8_t col = 0; col < MATRIX_COLS - 1; col++) {
-            uprintf("%4d,", runtime_ec_config.runtime_key_state[row][col].rescaled_rt_initial_deadzone_offset);
-        }
-        uprintf("%4d\n", runtime_ec_config.runtime_key_state[row][MATRIX_COLS - 1].rescaled_rt_initial_deadzone_offset);
-    }
-
-    uprintf("\n#######################################################\n");
-    uprintf("# Rapid Trigger Mode Actuation Offset                 #\n");
-    uprintf("#######################################################\n");
-    uprintf("Original Value: %4d\n", eeprom_ec_config.eeprom_key_state[0][0].rt_actuation_offset);
-    uprintf("Rescaled Values:\n");
-    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
-        for (uint8_t col = 0; col < MATRIX_COLS - 1; col++) {
-            uprintf("%4d,", runtime_ec_config.runtime_key_state[row][col].rescaled_rt_actuation_offset);
-        }
-        uprintf("%4d\n", runtime_ec_config.runtime_key_state[row][MATRIX_COLS - 1].rescaled_rt_actuation_offset);
-    }
-
-    uprintf("\n#######################################################\n");
-    uprintf("# Rapid Trigger Mode Release Offset                   #\n");
-    uprintf("#######################################################\n");
-    uprintf("Original Value: %4d\n", eeprom_ec_config.eeprom_key_state[0][0].rt_release_offset);
-    uprintf("Rescaled Values:\n");
-    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
-        for (uint8_t col = 0; col < MATRIX_COLS - 1; col++) {
-            uprintf("%4d,", runtime_ec_config.runtime_key_state[row][col].rescaled_rt_release_offset);
-        }
-        uprintf("%4d\n", runtime_ec_config.runtime_key_state[row][MATRIX_COLS - 1].rescaled_rt_release_offset);
-    }
-    print("\n");
+    ec_log_calibration_data();
 }
 
 // Clear the calibration data
@@ -639,9 +607,39 @@ static void ec_clear_bottoming_calibration_data(void) {
     // Reset the runtime values to the EEPROM values
     keyboard_post_init_kb();
 
-    uprintf("######################################\n");
-    uprintf("# Bottoming calibration data cleared #\n");
-    uprintf("######################################\n");
+#ifdef EC_ONLINE_CALIBRATION_ENABLE
+    // Drop the tracked readings, they would bring the cleared ones back
+    ec_online_calibration_reset();
+#endif
+
+    ec_log(EC_LOG_BOTTOMING_CALIBRATION_CLEARED, 0, 0);
+}
+
+// Convert a threshold from the VIA slider, the slider keeps the 0-EC_ADC_MAX range and spans the switch travel in mm mode
+static uint16_t ec_via_to_threshold(uint16_t value) {
+#    ifdef EC_TRAVEL_THRESHOLDS_MM
+    return ((uint32_t)MIN(value, EC_ADC_MAX) * EC_TRAVEL_TOTAL + EC_ADC_MAX / 2) / EC_ADC_MAX;
+#    else
+    return value;
+#    endif
+}
+
+// Convert a threshold to the VIA slider range
+static uint16_t ec_threshold_to_via(uint16_t threshold) {
+#    ifdef EC_TRAVEL_THRESHOLDS_MM
+    return ((uint32_t)MIN(threshold, EC_TRAVEL_TOTAL) * EC_ADC_MAX + EC_TRAVEL_TOTAL / 2) / EC_TRAVEL_TOTAL;
+#    else
+    return threshold;
+#    endif
+}
+
+// Range check an RT offset from the VIA slider, an offset in mm stays within the switch travel
+static uint16_t ec_via_to_offset(uint16_t value) {
+#    ifdef EC_TRAVEL_THRESHOLDS_MM
+    return MIN(value, EC_TRAVEL_TOTAL);
+#    else
+    return value;
+#    endif
 }
 
 // Handle the SOCD pairs configuration
@@ -692,13 +690,72 @@ static uint16_t socd_pair_handler(bool mode, uint8_t pair_idx, uint8_t field, ui
     }
 }
 
-// Slave handler for split keyboards
 #    ifdef SPLIT_KEYBOARD
-void via_cmd_slave_handler(uint8_t m2s_size, const void *m2s_buffer, uint8_t s2m_size, void *s2m_buffer) {
-    if (m2s_size == (RAW_EPSIZE - 2)) {
-        via_config_set_value((uint8_t *)m2s_buffer);
-    } else {
-        uprintf("Unexpected response in slave handler\n");
+// Apply a config delta received from the master
+void ec_split_apply_config(uint8_t *value_id_and_data) {
+    via_config_set_value(value_id_and_data);
+}
+
+// Queue the full current config for the slave, used to resync it
+void ec_split_queue_config_snapshot(void) {
+    uint8_t delta[EC_SPLIT_DELTA_SIZE];
+
+    // Indicators and actuation mode, encoded like the VIA set commands
+    for (uint8_t value_id = id_ind1_enabled; value_id <= id_actuation_mode; value_id++) {
+        delta[0] = value_id;
+        delta[1] = 0;
+        delta[2] = 0;
+        via_config_get_value(delta);
+        ec_split_queue_config(delta);
+    }
+
+    // Saved thresholds, then the saves so the slave rescales and stores them like the master did
+    eeprom_key_state_t *key_eeprom = &eeprom_ec_config.eeprom_key_state[0][0];
+    const uint16_t      saved[][2] = {
+        {id_apc_actuation_threshold, ec_threshold_to_via(key_eeprom->apc_actuation_threshold)},
+        {id_apc_release_threshold, ec_threshold_to_via(key_eeprom->apc_release_threshold)},
+        {id_rt_initial_deadzone_offset, ec_threshold_to_via(key_eeprom->rt_initial_deadzone_offset)},
+        {id_rt_actuation_offset, key_eeprom->rt_actuation_offset},
+        {id_rt_release_offset, key_eeprom->rt_release_offset},
+    };
+    for (uint8_t i = 0; i < ARRAY_SIZE(saved); i++) {
+        delta[0] = saved[i][0];
+        delta[1] = saved[i][1] >> 8;
+        delta[2] = saved[i][1] & 0xFF;
+#    ifndef EC_ADC_12BIT
+        // The RT offsets are a single byte
+        if (saved[i][0] == id_rt_actuation_offset || saved[i][0] == id_rt_release_offset) {
+            delta[1] = saved[i][1];
+        }
+#    endif
+        ec_split_queue_config(delta);
+    }
+    for (uint8_t option = 0; option <= 1; option++) {
+        delta[0] = id_save_threshold_data;
+        delta[1] = option;
+        delta[2] = 0;
+        ec_split_queue_config(delta);
+    }
+
+    // Thresholds being edited on the master and not saved yet
+    for (uint8_t value_id = id_apc_actuation_threshold; value_id <= id_rt_release_offset; value_id++) {
+        if (value_id == id_save_threshold_data) {
+            continue;
+        }
+        delta[0] = value_id;
+        delta[1] = 0;
+        delta[2] = 0;
+        via_config_get_value(delta);
+        ec_split_queue_config(delta);
+    }
+
+    // SOCD pairs
+    for (uint8_t value_id = id_socd_pair_1_mode; value_id <= id_socd_pair_4_key_2; value_id++) {
+        delta[0] = value_id;
+        delta[1] = 0;
+        delta[2] = 0;
+        via_config_get_value(delta);
+        ec_split_queue_config(delta);
     }
 }
 #    endif
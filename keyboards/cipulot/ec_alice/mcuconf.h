@@ -23,3 +23,8 @@
 
 #undef STM32_PWM_USE_TIM4
 #define STM32_PWM_USE_TIM4 TRUE
+
+#ifdef EC_FIXED_RATE_SCAN_ENABLE
+#    undef STM32_GPT_USE_TIM9
+#    define STM32_GPT_USE_TIM9 TRUE
+#endif
@@ -0,0 +1,95 @@
+# Binary analog value streaming over raw HID
+ifeq ($(strip $(EC_ANALOG_STREAM_ENABLE)), yes)
+    RAW_ENABLE = yes
+    OPT_DEFS += -DEC_ANALOG_STREAM_ENABLE
+    SRC += ec_analog_stream.c
+endif
+
+# Versioned config sync with the slave half
+ifeq ($(strip $(SPLIT_KEYBOARD)), yes)
+    SRC += ec_split.c
+endif
+
+# Reduced rate matrix scanning while every key rests at its noise floor
+ifeq ($(strip $(EC_IDLE_SCAN_ENABLE)), yes)
+    OPT_DEFS += -DEC_IDLE_SCAN_ENABLE
+endif
+
+# Analog MIDI controller mode
+ifeq ($(strip $(EC_MIDI_ENABLE)), yes)
+    MIDI_ENABLE = yes
+    RAW_ENABLE = yes
+    OPT_DEFS += -DEC_MIDI_ENABLE
+    SRC += ec_midi.c
+endif
+
+# Analog proportional mouse movement
+ifeq ($(strip $(EC_ANALOG_MOUSE_ENABLE)), yes)
+    OPT_DEFS += -DEC_ANALOG_MOUSE_ENABLE
+    SRC += ec_analog_mouse.c
+endif
+
+# Analog hysteresis aware debounce, replaced by the generic ones if DEBOUNCE_TYPE is overridden
+ifeq ($(strip $(DEBOUNCE_TYPE)), custom)
+    SRC += ec_debounce.c
+endif
+
+# Thresholds given in 0.01 mm of travel, mapped through the switch travel curve
+ifeq ($(strip $(EC_TRAVEL_THRESHOLDS_MM)), yes)
+    OPT_DEFS += -DEC_TRAVEL_THRESHOLDS_MM
+    SRC += ec_travel.c
+endif
+
+# Bottom-out calibration tracked during normal use
+ifeq ($(strip $(EC_ONLINE_CALIBRATION_ENABLE)), yes)
+    OPT_DEFS += -DEC_ONLINE_CALIBRATION_ENABLE
+endif
+
+# Supply voltage compensation of the switch readings through VREFINT
+ifeq ($(strip $(EC_VREFINT_ENABLE)), yes)
+    OPT_DEFS += -DEC_VREFINT_ENABLE
+endif
+
+# Noise floor drift compensation from the internal temperature sensor
+ifeq ($(strip $(EC_TEMP_COMPENSATION_ENABLE)), yes)
+    OPT_DEFS += -DEC_TEMP_COMPENSATION_ENABLE
+endif
+
+# WS2812 frames sent between matrix scans, replaces the stock PWM driver
+ifeq ($(strip $(EC_WS2812_SCHEDULED)), yes)
+    ifeq ($(strip $(RGBLIGHT_ENABLE)), yes)
+        WS2812_DRIVER = custom
+        OPT_DEFS += -DEC_WS2812_SCHEDULED
+        SRC += ec_ws2812.c
+    endif
+endif
+
+# Matrix scans phase-locked to the USB start of frame
+ifeq ($(strip $(EC_SOF_SYNC_ENABLE)), yes)
+    OPT_DEFS += -DEC_SOF_SYNC_ENABLE
+endif
+
+# Matrix scans started at a fixed rate by a hardware timer, the core sleeps in between
+ifeq ($(strip $(EC_FIXED_RATE_SCAN_ENABLE)), yes)
+    OPT_DEFS += -DEC_FIXED_RATE_SCAN_ENABLE
+endif
+
+# Matrix scans triaged with fast coarse reads, full precision reads only close to a decision
+ifeq ($(strip $(EC_TWO_TIER_SCAN_ENABLE)), yes)
+    OPT_DEFS += -DEC_TWO_TIER_SCAN_ENABLE
+endif
+
+# Matrix scan hot path executed from SRAM
+ifeq ($(strip $(EC_SCAN_FROM_SRAM)), yes)
+    OPT_DEFS += -DEC_SCAN_FROM_SRAM
+endif
+
+# Matrix scan loop timing statistics
+ifeq ($(strip $(EC_SCAN_TIMING_ENABLE)), yes)
+    OPT_DEFS += -DEC_SCAN_TIMING_ENABLE
+endif
+
+# Switch readings at the full 12 bit ADC resolution
+ifeq ($(strip $(EC_ADC_12BIT)), yes)
+    OPT_DEFS += -DEC_ADC_12BIT
+endif
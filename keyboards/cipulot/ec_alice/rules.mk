@@ -1,6 +1,7 @@
 CUSTOM_MATRIX = lite
 ANALOG_DRIVER_REQUIRED = yes
-SRC += matrix.c ec_switch_matrix.c
+DEBOUNCE_TYPE = custom
+SRC += matrix.c ec_switch_matrix.c ec_log.c
 
 MCUFLAGS += -march=armv7e-m \
             -mcpu=cortex-m4 \
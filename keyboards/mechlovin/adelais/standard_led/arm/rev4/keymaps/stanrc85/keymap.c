@@ -14,6 +14,7 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include QMK_KEYBOARD_H
+#include "idle_manager.h"
 
 enum my_keycodes {
   BL_TOG = QK_KB_0,
@@ -39,13 +40,8 @@ bool led_update_user(led_t led_state) {
     return false;
 }
 
-bool suspended = false;
 void housekeeping_task_user(void) {
-    if (last_matrix_activity_elapsed() > RGBLIGHT_TIMEOUT)
-    {
-        rgblight_suspend();
-        suspended = true;
-    }
+    idle_manager_task();
 }
 
 const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
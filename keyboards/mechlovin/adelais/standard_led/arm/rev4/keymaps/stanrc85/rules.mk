@@ -6,3 +6,4 @@ LAYER_LOCK_ENABLE = no
 REPEAT_KEY_ENABLE = no
 TAP_DANCE_ENABLE = yes
 LTO_ENABLE = yes
+IDLE_MANAGER_ENABLE = yes
@@ -8,3 +8,4 @@ MOUSEKEY_ENABLE = no
 AUDIO_ENABLE = no
 CONSOLE_ENABLE = no
 REPEAT_KEY_ENABLE = no
+IDLE_MANAGER_ENABLE = yes
@@ -15,6 +15,7 @@
  */
 
 #include QMK_KEYBOARD_H
+#include "shift_caps.h"
 
 // Tap dance: double-tap Left Shift to toggle Caps Lock
 enum {
@@ -22,42 +23,16 @@ enum {
   TD_ALT_SPC_LGUI,
 };
 
-void dance_lshift_caps_finished(tap_dance_state_t *state, void *user_data);
-void dance_lshift_caps_reset(tap_dance_state_t *state, void *user_data);
-
 void dance_alt_spc_finished(tap_dance_state_t *state, void *user_data);
 void dance_alt_spc_reset(tap_dance_state_t *state, void *user_data);
 
 tap_dance_action_t tap_dance_actions[] = {
-  [TD_LSFT_CAPS] = ACTION_TAP_DANCE_FN_ADVANCED(NULL, dance_lshift_caps_finished, dance_lshift_caps_reset),
+  [TD_LSFT_CAPS] = ACTION_TAP_DANCE_SHIFT_CAPS(),
   [TD_ALT_SPC_LGUI] = ACTION_TAP_DANCE_FN_ADVANCED(NULL, dance_alt_spc_finished, dance_alt_spc_reset),
 };
 
-static bool lsft_registered = false;
 static bool lgui_registered = false;
 
-void dance_lshift_caps_finished(tap_dance_state_t *state, void *user_data) {
-  if (state->count == 1) {
-    // Single tap: behave as regular Shift when held, or a tap when quickly pressed
-    if (state->pressed) {
-      register_code(KC_LSFT);
-      lsft_registered = true;
-    } else {
-      tap_code(KC_LSFT);
-    }
-  } else if (state->count == 2) {
-    // Double tap: toggle Caps Lock
-    tap_code(KC_CAPS);
-  }
-}
-
-void dance_lshift_caps_reset(tap_dance_state_t *state, void *user_data) {
-  if (lsft_registered) {
-    unregister_code(KC_LSFT);
-    lsft_registered = false;
-  }
-}
-
 void dance_alt_spc_finished(tap_dance_state_t *state, void *user_data) {
   if (state->count == 1) {
     if (state->pressed) {
@@ -1,2 +1,3 @@
 VIA_ENABLE = yes
 TAP_DANCE_ENABLE = yes
+SHIFT_CAPS_ENABLE = yes
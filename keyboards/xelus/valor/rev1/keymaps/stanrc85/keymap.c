@@ -14,6 +14,7 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include QMK_KEYBOARD_H
+#include "idle_manager.h"
 
 enum my_layers {
   _NUMPAD = 0,  //Macropad numpad
@@ -72,47 +73,6 @@ const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
   )
 };
 
-//RGB Timeout
-
-static uint32_t key_timer; // timer to track the last keyboard activity
-static void refresh_rgb(void); // refreshes the activity timer and RGB, invoke whenever activity happens
-static void check_rgb_timeout(void); // checks if enough time has passed for RGB to timeout
-bool is_rgb_timeout = false; // store if RGB has timed out or not in a boolean
-
-
-void refresh_rgb() {
-  key_timer = timer_read32(); // store time of last refresh
-  if (is_rgb_timeout) { // only do something if rgb has timed out
-    print("Activity detected, turning on RGB\n");
-    is_rgb_timeout = false;
-    rgblight_wakeup();
-  }
-}
-
-void check_rgb_timeout() {
-  if (!is_rgb_timeout && timer_elapsed32(key_timer) > RGBLIGHT_TIMEOUT) {
-    rgblight_suspend();
-    print("Idle timeout reached, turning off RGB\n");
-    is_rgb_timeout = true;
-  }
-}
-
-
 void housekeeping_task_user(void) {
-  #ifdef RGBLIGHT_TIMEOUT
-  check_rgb_timeout();
-  #endif
-}
-
-void post_process_record_user(uint16_t keycode, keyrecord_t *record) {
-  #ifdef RGBLIGHT_TIMEOUT
-  if (record->event.pressed) refresh_rgb();
-  #endif
-}
-
-
-void post_encoder_update_user(uint8_t index, bool clockwise) {
-  #ifdef RGBLIGHT_TIMEOUT
-  refresh_rgb();
-  #endif
+  idle_manager_task();
 }
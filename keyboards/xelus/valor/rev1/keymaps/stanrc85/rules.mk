@@ -10,3 +10,4 @@ CONSOLE_ENABLE = no
 REPEAT_KEY_ENABLE = no
 TAP_DANCE_ENABLE = yes
 QMK_SETTINGS = yes
+IDLE_MANAGER_ENABLE = yes
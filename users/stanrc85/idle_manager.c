@@ -0,0 +1,78 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "idle_manager.h"
+#include "quantum.h"
+
+static idle_stage_t    current_stage = IDLE_STAGE_ACTIVE;
+static idle_callback_t subscribers[IDLE_MAX_SUBSCRIBERS];
+static uint8_t         subscriber_count = 0;
+
+#ifdef RGBLIGHT_ENABLE
+static bool    dimmed     = false; // Brightness was lowered by the dim stage
+static uint8_t normal_val = 0;     // Brightness to restore when leaving the dim stage
+
+// Apply the lighting side of a stage transition
+static void idle_lighting_transition(idle_stage_t old_stage, idle_stage_t new_stage) {
+    if (old_stage == IDLE_STAGE_OFF) {
+        rgblight_wakeup();
+    }
+    if (dimmed && new_stage == IDLE_STAGE_ACTIVE) {
+        rgblight_sethsv_noeeprom(rgblight_get_hue(), rgblight_get_sat(), normal_val);
+        dimmed = false;
+    }
+    if (!dimmed && new_stage == IDLE_STAGE_DIM && rgblight_is_enabled()) {
+        normal_val = rgblight_get_val();
+        rgblight_sethsv_noeeprom(rgblight_get_hue(), rgblight_get_sat(), normal_val / IDLE_DIM_DIVISOR);
+        dimmed = true;
+    }
+    if (new_stage == IDLE_STAGE_OFF) {
+        rgblight_suspend();
+    }
+}
+#endif
+
+// Stage matching the time since the last input activity
+static idle_stage_t idle_stage_for(uint32_t elapsed) {
+    if (elapsed >= IDLE_OFF_TIMEOUT) {
+        return IDLE_STAGE_OFF;
+    }
+    if (elapsed >= IDLE_DIM_TIMEOUT) {
+        return IDLE_STAGE_DIM;
+    }
+    return IDLE_STAGE_ACTIVE;
+}
+
+// Track input activity and run the transitions, call from housekeeping_task_user()
+void idle_manager_task(void) {
+    idle_stage_t new_stage = idle_stage_for(last_input_activity_elapsed());
+
+    // Only act on stage changes
+    if (new_stage == current_stage) {
+        return;
+    }
+
+    idle_stage_t old_stage = current_stage;
+    current_stage          = new_stage;
+    dprintf("Idle stage %u -> %u\n", old_stage, new_stage);
+
+#ifdef RGBLIGHT_ENABLE
+    idle_lighting_transition(old_stage, new_stage);
+#endif
+    for (uint8_t i = 0; i < subscriber_count; i++) {
+        subscribers[i](old_stage, new_stage);
+    }
+}
+
+// Register a callback for the idle stage transitions
+bool idle_manager_subscribe(idle_callback_t callback) {
+    if (subscriber_count >= IDLE_MAX_SUBSCRIBERS) {
+        return false;
+    }
+    subscribers[subscriber_count++] = callback;
+    return true;
+}
+
+// Get the current idle stage
+idle_stage_t idle_manager_stage(void) {
+    return current_stage;
+}
@@ -0,0 +1,46 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Inactivity before the lighting is turned off in ms
+#ifndef IDLE_OFF_TIMEOUT
+#    ifdef RGBLIGHT_TIMEOUT
+#        define IDLE_OFF_TIMEOUT RGBLIGHT_TIMEOUT
+#    else
+#        define IDLE_OFF_TIMEOUT 600000
+#    endif
+#endif
+
+// Inactivity before the lighting is dimmed in ms, dimming is skipped unless set below IDLE_OFF_TIMEOUT
+#ifndef IDLE_DIM_TIMEOUT
+#    define IDLE_DIM_TIMEOUT IDLE_OFF_TIMEOUT
+#endif
+
+// Brightness divisor applied while dimmed
+#ifndef IDLE_DIM_DIVISOR
+#    define IDLE_DIM_DIVISOR 4
+#endif
+
+// Maximum number of idle transition subscribers
+#ifndef IDLE_MAX_SUBSCRIBERS
+#    define IDLE_MAX_SUBSCRIBERS 4
+#endif
+
+_Static_assert(IDLE_DIM_TIMEOUT <= IDLE_OFF_TIMEOUT, "IDLE_DIM_TIMEOUT must not exceed IDLE_OFF_TIMEOUT");
+
+// Idle stages, ordered by depth
+typedef enum {
+    IDLE_STAGE_ACTIVE = 0, // Recent input activity
+    IDLE_STAGE_DIM,        // Lighting dimmed
+    IDLE_STAGE_OFF         // Lighting off
+} idle_stage_t;
+
+// Called on every stage transition, from housekeeping
+typedef void (*idle_callback_t)(idle_stage_t old_stage, idle_stage_t new_stage);
+
+void         idle_manager_task(void);
+bool         idle_manager_subscribe(idle_callback_t callback);
+idle_stage_t idle_manager_stage(void);
@@ -0,0 +1,12 @@
+# Shared idle and power manager
+ifeq ($(strip $(IDLE_MANAGER_ENABLE)), yes)
+    OPT_DEFS += -DIDLE_MANAGER_ENABLE
+    SRC += idle_manager.c
+endif
+
+# Instant Shift tap dance with double tap Caps Lock
+ifeq ($(strip $(SHIFT_CAPS_ENABLE)), yes)
+    TAP_DANCE_ENABLE = yes
+    OPT_DEFS += -DSHIFT_CAPS_ENABLE
+    SRC += shift_caps.c
+endif
@@ -0,0 +1,36 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "shift_caps.h"
+
+static bool lsft_registered = false;
+
+// Runs on every press, before the tap dance resolves
+void shift_caps_on_each_tap(tap_dance_state_t *state, void *user_data) {
+    if (state->count == 1) {
+        // First press: Shift right away, no tapping term delay for the next key
+        register_code(KC_LSFT);
+        lsft_registered = true;
+    } else if (state->count == 2) {
+        // Second tap in time: drop the Shift and toggle Caps Lock instead
+        if (lsft_registered) {
+            unregister_code(KC_LSFT);
+            lsft_registered = false;
+        }
+        tap_code(KC_CAPS);
+    }
+}
+
+// Runs on every release, the Shift only lasts as long as the key is held
+void shift_caps_on_each_release(tap_dance_state_t *state, void *user_data) {
+    if (lsft_registered) {
+        unregister_code(KC_LSFT);
+        lsft_registered = false;
+    }
+}
+
+void shift_caps_reset(tap_dance_state_t *state, void *user_data) {
+    if (lsft_registered) {
+        unregister_code(KC_LSFT);
+        lsft_registered = false;
+    }
+}
@@ -0,0 +1,12 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+#pragma once
+
+#include "quantum.h"
+
+// Left Shift registered on press, a second tap within the tapping term toggles Caps Lock instead
+#define ACTION_TAP_DANCE_SHIFT_CAPS() ACTION_TAP_DANCE_FN_ADVANCED_WITH_RELEASE(shift_caps_on_each_tap, shift_caps_on_each_release, NULL, shift_caps_reset)
+
+void shift_caps_on_each_tap(tap_dance_state_t *state, void *user_data);
+void shift_caps_on_each_release(tap_dance_state_t *state, void *user_data);
+void shift_caps_reset(tap_dance_state_t *state, void *user_data);